@@ -0,0 +1,37 @@
+#pragma once
+#include "componentStorage.h"
+#include "archetypeStore.h"
+#include "entityID.h"
+#include "../utils/span.h"
+
+namespace EECS {
+// Forwards all operations to the ArchetypeStore shared by all archetype-stored types of ComponentManager.
+template <class T>
+class ComponentStorage<T, ArchetypeStorage> : public LoopedBulkOperations<ComponentStorage<T, ArchetypeStorage>> {
+   public:
+    static constexpr bool sorted = false;
+
+    // registers T up front, so views of it never have to.
+    void setStore(ArchetypeStore& store) {
+        this->store = &store;
+        store.registerType<T>();
+    }
+
+    T* get(EntityID entityID) { return store->get<T>(entityID); }
+
+    template <typename... Args>
+    T* add(EntityID entityID, Args&&... args) {
+        return store->add<T>(entityID, std::forward<Args>(args)...);
+    }
+
+    bool remove(EntityID entityID) { return store->remove<T>(entityID); }
+
+    void clear() { store->clear<T>(); }
+
+   private:
+    ArchetypeStore* store = nullptr;
+};
+
+template <class T>
+constexpr bool ComponentStorage<T, ArchetypeStorage>::sorted;
+}
@@ -0,0 +1,237 @@
+#include "archetypeStore.h"
+#include <algorithm>
+
+using namespace EECS;
+
+constexpr size_t Archetype::chunkSize;
+constexpr size_t Archetype::noColumn;
+constexpr size_t ArchetypeStore::noType;
+
+namespace {
+size_t alignUp(size_t offset, size_t alignment) { return (offset + alignment - 1) / alignment * alignment; }
+}
+
+Archetype::Archetype(std::vector<size_t> componentTypes, const std::vector<ArchetypeComponentType>& typeInfo)
+    : componentTypes(std::move(componentTypes)) {
+    for (auto type : this->componentTypes) {
+        columnTypes.push_back(typeInfo[type]);
+    }
+
+    columnByType.assign(this->componentTypes.back() + 1, noColumn);
+    for (auto column = 0u; column < this->componentTypes.size(); column++) {
+        columnByType[this->componentTypes[column]] = column;
+    }
+
+    // computes column offsets for given number of rows per chunk, returns bytes needed by the chunk.
+    auto layout = [this](size_t rowsPerChunk) {
+        columnOffsets.clear();
+        auto offset = rowsPerChunk * sizeof(EntityID);
+        for (const auto& type : columnTypes) {
+            offset = alignUp(offset, type.alignment);
+            columnOffsets.push_back(offset);
+            offset += rowsPerChunk * type.size;
+        }
+        return offset;
+    };
+
+    auto rowSize = sizeof(EntityID);
+    for (const auto& type : columnTypes) {
+        rowSize += type.size;
+    }
+
+    capacity = std::max<size_t>(1, chunkSize / rowSize);
+    while (capacity > 1 && layout(capacity) > chunkSize) {
+        capacity--;
+    }
+    chunkBytes = std::max(chunkSize, layout(capacity));
+}
+
+Archetype::~Archetype() {
+    for (auto row = 0u; row < rows; row++) {
+        destroyRow(row);
+    }
+}
+
+size_t Archetype::allocateRow(EntityID entity) {
+    if (rows == chunks.size() * capacity) {
+        auto elements = (chunkBytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+        chunks.emplace_back(new std::max_align_t[elements]);
+    }
+
+    auto row = rows++;
+    entities(row / capacity)[row % capacity] = entity;
+    return row;
+}
+
+EntityID Archetype::fillHole(size_t row) {
+    auto last = rows - 1;
+    EntityID movedEntity = 0;
+
+    if (row != last) {
+        for (auto column = 0u; column < columnTypes.size(); column++) {
+            columnTypes[column].relocate(component(row, column), component(last, column));
+        }
+
+        movedEntity = entity(last);
+        entities(row / capacity)[row % capacity] = movedEntity;
+    }
+
+    rows--;
+    if (chunks.size() * capacity >= rows + 2 * capacity) {  // keep one spare chunk, to not thrash at the boundary
+        chunks.pop_back();
+    }
+
+    return movedEntity;
+}
+
+void Archetype::destroyRow(size_t row) {
+    for (auto column = 0u; column < columnTypes.size(); column++) {
+        columnTypes[column].destroy(component(row, column));
+    }
+}
+
+void ArchetypeStore::clear() {
+    locations.clear();
+    archetypesBySignature.clear();
+    archetypes.clear();
+}
+
+ArchetypeStore::EntityLocation* ArchetypeStore::locate(EntityID entityID) {
+    auto index = entityIndex(entityID);
+    if (index >= locations.size() || locations[index].entity != entityID || !locations[index].archetype) {
+        return nullptr;
+    }
+
+    return &locations[index];
+}
+
+ArchetypeStore::EntityLocation& ArchetypeStore::locateOrInsert(EntityID entityID) {
+    auto index = entityIndex(entityID);
+    if (index >= locations.size()) {
+        locations.resize(index + 1);
+    }
+
+    auto& location = locations[index];
+    if (location.entity != entityID) {
+        // components left by the entity which previously occupied this index are dead
+        if (location.archetype) {
+            purge(location);
+        }
+        location.entity = entityID;
+    }
+
+    return location;
+}
+
+Archetype* ArchetypeStore::archetypeWith(Archetype* source, size_t componentType) {
+    if (source) {
+        auto cached = source->withComponent.find(componentType);
+        if (cached != source->withComponent.end()) {
+            return cached->second;
+        }
+    }
+
+    auto signature = source ? source->getComponentTypes() : std::vector<size_t>{};
+    signature.insert(std::lower_bound(signature.begin(), signature.end(), componentType), componentType);
+
+    auto target = findOrCreateArchetype(signature);
+    if (source) {
+        source->withComponent[componentType] = target;
+        target->withoutComponent[componentType] = source;
+    }
+
+    return target;
+}
+
+Archetype* ArchetypeStore::archetypeWithout(Archetype* source, size_t componentType) {
+    auto cached = source->withoutComponent.find(componentType);
+    if (cached != source->withoutComponent.end()) {
+        return cached->second;
+    }
+
+    auto signature = source->getComponentTypes();
+    signature.erase(std::lower_bound(signature.begin(), signature.end(), componentType));
+    if (signature.empty()) {
+        return nullptr;
+    }
+
+    auto target = findOrCreateArchetype(signature);
+    source->withoutComponent[componentType] = target;
+    target->withComponent[componentType] = source;
+
+    return target;
+}
+
+Archetype* ArchetypeStore::findOrCreateArchetype(const std::vector<size_t>& signature) {
+    auto existing = archetypesBySignature.find(signature);
+    if (existing != archetypesBySignature.end()) {
+        return existing->second;
+    }
+
+    archetypes.emplace_back(std::make_unique<Archetype>(signature, componentTypes));
+    archetypesBySignature[signature] = archetypes.back().get();
+    return archetypes.back().get();
+}
+
+void ArchetypeStore::move(EntityLocation& location, Archetype* target) {
+    auto source = location.archetype;
+    auto targetRow = target->allocateRow(location.entity);
+
+    if (source) {
+        for (auto column = 0u; column < source->componentTypes.size(); column++) {
+            auto targetColumn = target->column(source->componentTypes[column]);
+            if (targetColumn != Archetype::noColumn) {
+                source->columnTypes[column].relocate(target->component(targetRow, targetColumn),
+                                                     source->component(location.row, column));
+            } else {
+                source->columnTypes[column].destroy(source->component(location.row, column));
+            }
+        }
+
+        auto movedEntity = source->fillHole(location.row);
+        if (movedEntity) {
+            locations[entityIndex(movedEntity)].row = location.row;
+        }
+    }
+
+    location.archetype = target;
+    location.row = targetRow;
+}
+
+void ArchetypeStore::purge(EntityLocation& location) {
+    location.archetype->destroyRow(location.row);
+
+    auto movedEntity = location.archetype->fillHole(location.row);
+    if (movedEntity) {
+        locations[entityIndex(movedEntity)].row = location.row;
+    }
+
+    location.archetype = nullptr;
+}
+
+bool ArchetypeStore::removeComponent(EntityID entityID, size_t componentType) {
+    auto location = locate(entityID);
+    if (!location || !location->archetype->has(componentType)) {
+        return false;
+    }
+
+    auto target = archetypeWithout(location->archetype, componentType);
+    if (target) {
+        move(*location, target);
+    } else {
+        purge(*location);
+    }
+
+    return true;
+}
+
+void ArchetypeStore::clearComponentType(size_t componentType) {
+    // removal can create new archetypes, but these won't have this component type
+    auto archetypeCount = archetypes.size();
+    for (auto i = 0u; i < archetypeCount; i++) {
+        auto& archetype = *archetypes[i];
+        while (archetype.has(componentType) && archetype.size() > 0) {
+            removeComponent(archetype.entity(archetype.size() - 1), componentType);
+        }
+    }
+}
@@ -0,0 +1,231 @@
+#pragma once
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <algorithm>
+#include <limits>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include "entityID.h"
+#include "componentContainerID.h"
+
+namespace EECS {
+// Type-erased operations on a component type stored in archetypes.
+struct ArchetypeComponentType {
+    size_t size = 0;
+    size_t alignment = 0;
+
+    // move-constructs component at destination from the one at source, then destroys the source.
+    void (*relocate)(void* destination, void* source) = nullptr;
+    void (*destroy)(void* component) = nullptr;
+
+    template <class T>
+    static ArchetypeComponentType of() {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned components can't be stored in archetypes");
+
+        ArchetypeComponentType type;
+        type.size = sizeof(T);
+        type.alignment = alignof(T);
+        type.relocate = [](void* destination, void* source) {
+            new (destination) T(std::move(*(T*)source));
+            ((T*)source)->~T();
+        };
+        type.destroy = [](void* component) { ((T*)component)->~T(); };
+        return type;
+    }
+};
+
+/** \brief all entities having exactly the same set of archetype-stored component types
+*
+* Entities are stored in fixed-size(chunkSize bytes) chunks. Each chunk holds entity ids and one column per component
+* type, so iterating over components of the archetype is a linear scan over a few arrays.
+* Rows are kept dense: removing entity moves the last row into freed place.
+*/
+class Archetype {
+   public:
+    static constexpr size_t chunkSize = 16 * 1024;
+    static constexpr size_t noColumn = std::numeric_limits<size_t>::max();
+
+    Archetype(std::vector<size_t> componentTypes, const std::vector<ArchetypeComponentType>& typeInfo);
+    ~Archetype();
+
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+
+    // sorted ComponentContainerIDs of component types stored in this archetype.
+    const std::vector<size_t>& getComponentTypes() const { return componentTypes; }
+
+    // index of column storing given component type, or noColumn if archetype doesn't have it.
+    size_t column(size_t componentType) const {
+        return componentType < columnByType.size() ? columnByType[componentType] : noColumn;
+    }
+
+    bool has(size_t componentType) const { return column(componentType) != noColumn; }
+
+    size_t size() const { return rows; }
+    size_t chunkCount() const { return chunks.size(); }
+    size_t chunkCapacity() const { return capacity; }
+    size_t rowsInChunk(size_t chunk) const {
+        return chunk * capacity >= rows ? 0 : std::min(capacity, rows - chunk * capacity);
+    }
+
+    // pointer to the first element of given column in given chunk.
+    void* columnData(size_t chunk, size_t column) { return chunkMemory(chunk) + columnOffsets[column]; }
+    EntityID* entities(size_t chunk) { return (EntityID*)chunkMemory(chunk); }
+
+    void* component(size_t row, size_t column) {
+        return (char*)columnData(row / capacity, column) + (row % capacity) * columnTypes[column].size;
+    }
+
+    EntityID entity(size_t row) { return entities(row / capacity)[row % capacity]; }
+
+   private:
+    std::vector<size_t> componentTypes;
+    std::vector<ArchetypeComponentType> columnTypes;
+    std::vector<size_t> columnOffsets;
+    std::vector<size_t> columnByType;
+    size_t capacity;
+    size_t chunkBytes;
+
+    std::vector<std::unique_ptr<std::max_align_t[]>> chunks;
+    size_t rows = 0;
+
+    // archetypes which differ from this one by a single type, cached to make moving entities between them cheap.
+    std::unordered_map<size_t, Archetype*> withComponent;
+    std::unordered_map<size_t, Archetype*> withoutComponent;
+
+    char* chunkMemory(size_t chunk) { return (char*)chunks[chunk].get(); }
+
+    // appends row with given entity and uninitialized components. Returns its index.
+    size_t allocateRow(EntityID entity);
+
+    // fills row whose components were already destroyed or relocated with the last row, and shrinks archetype.
+    // Returns entity which was moved into the row, or 0 if the row was the last one.
+    EntityID fillHole(size_t row);
+
+    // destroys all components in the row.
+    void destroyRow(size_t row);
+
+    friend class ArchetypeStore;
+};
+
+/** \brief stores components, whose Storage is ArchetypeStorage, grouped by archetypes
+*
+* Adding or deleting component moves entity's archetype-stored components to the archetype with one type more or less.
+* Each ComponentManager owns one ArchetypeStore, shared by all archetype-stored component types.
+*/
+class ArchetypeStore {
+   public:
+    // returns pointer to component owned by given entity, in O(1). nullptr if it doesn't exist.
+    template <class T>
+    T* get(EntityID entityID) {
+        auto location = locate(entityID);
+        if (!location) {
+            return nullptr;
+        }
+
+        auto column = location->archetype->column(ComponentContainerID::get<T>());
+        if (column == Archetype::noColumn) {
+            return nullptr;
+        }
+
+        return (T*)location->archetype->component(location->row, column);
+    }
+
+    // adds component, or replaces existing one. Pointers to other components of the entity are invalidated.
+    template <class T, class... Args>
+    T* add(EntityID entityID, Args&&... args) {
+        T component(std::forward<Args>(args)...);
+        component.entityID = entityID;
+
+        auto type = registerType<T>();
+        auto& location = locateOrInsert(entityID);
+        auto column = location.archetype ? location.archetype->column(type) : Archetype::noColumn;
+
+        if (column != Archetype::noColumn) {
+            auto existing = (T*)location.archetype->component(location.row, column);
+            *existing = std::move(component);
+            return existing;
+        }
+
+        move(location, archetypeWith(location.archetype, type));
+        auto place = location.archetype->component(location.row, location.archetype->column(type));
+        return new (place) T(std::move(component));
+    }
+
+    template <class T>
+    bool remove(EntityID entityID) {
+        return removeComponent(entityID, typeID<T>());
+    }
+
+    // deletes all components of type T.
+    template <class T>
+    void clear() {
+        clearComponentType(typeID<T>());
+    }
+
+    // deletes all components.
+    void clear();
+
+    // registers type in the store, if it's not yet, and returns its ComponentContainerID. Called when container of
+    // the type is created, and by add; must not run concurrently with anything else touching the store.
+    template <class T>
+    size_t registerType() {
+        auto id = ComponentContainerID::get<T>();
+        if (componentTypes.size() <= id) {
+            componentTypes.resize(id + 1);
+        }
+
+        if (!componentTypes[id].relocate) {
+            componentTypes[id] = ArchetypeComponentType::of<T>();
+        }
+
+        return id;
+    }
+
+    // ComponentContainerID of registered type, or noType, which no archetype has. Doesn't modify the store, so it's
+    // safe to call from many readers at once.
+    template <class T>
+    size_t typeID() const {
+        auto id = ComponentContainerID::get<T>();
+        return id < componentTypes.size() && componentTypes[id].relocate ? id : noType;
+    }
+
+    static constexpr size_t noType = std::numeric_limits<size_t>::max();
+
+    // all archetypes created so far, including empty ones. New archetypes are always appended.
+    const std::vector<std::unique_ptr<Archetype>>& getArchetypes() const { return archetypes; }
+
+   private:
+    struct EntityLocation {
+        EntityID entity = 0;
+        Archetype* archetype = nullptr;
+        size_t row = 0;
+    };
+
+    std::vector<ArchetypeComponentType> componentTypes;
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::map<std::vector<size_t>, Archetype*> archetypesBySignature;
+    std::vector<EntityLocation> locations;  // indexed by entityIndex
+
+    // location of entity which has at least one archetype-stored component, or nullptr.
+    EntityLocation* locate(EntityID entityID);
+    EntityLocation& locateOrInsert(EntityID entityID);
+
+    Archetype* archetypeWith(Archetype* source, size_t componentType);
+    Archetype* archetypeWithout(Archetype* source, size_t componentType);
+    Archetype* findOrCreateArchetype(const std::vector<size_t>& signature);
+
+    // moves entity to target archetype. Components of types target has, but source doesn't, are left uninitialized;
+    // components of types source has, but target doesn't, are destroyed.
+    void move(EntityLocation& location, Archetype* target);
+
+    // removes entity from its archetype, destroying all its components.
+    void purge(EntityLocation& location);
+
+    bool removeComponent(EntityID entityID, size_t componentType);
+    void clearComponentType(size_t componentType);
+};
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <tuple>
+#include <array>
+#include <iterator>
+#include <cstddef>
+#include "archetypeStore.h"
+
+namespace EECS {
+/** \brief lazy range of entities which have *at least* all given archetype-stored component types
+*
+* Equivalent of ComponentView for types with ArchetypeStorage. It walks through all chunks of archetypes which contain
+* all requested types, so each element costs just an increment of a few pointers. It yields tuple of references to
+* the components, like ComponentView.
+*
+* forEachChunk gives access to whole columns at once, for ex. for vectorized processing:
+* view.forEachChunk([](size_t count, EntityID* entities, PositionComponent* positions, VelocityComponent* velocities) {
+*     for (auto i = 0u; i < count; i++) { positions[i].x += velocities[i].x; }
+* });
+*
+* Creating a view doesn't modify the store, so many views can be created and iterated concurrently.
+* Adding or deleting archetype-stored components while iterating invalidates iterators.
+*/
+template <typename... Types>
+class ArchetypeView {
+   public:
+    using Components = std::tuple<Types&...>;
+
+    class Iterator {
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Components;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Components;
+
+        Components operator*() const { return Components(std::get<Types*>(columns)[row]...); }
+
+        EntityID entity() const { return entities[row]; }
+
+        Iterator& operator++() {
+            if (++row == rowsInChunk) {
+                row = 0;
+                chunk++;
+                findChunk();
+            }
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            auto previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return archetype == other.archetype && chunk == other.chunk && row == other.row;
+        }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+       private:
+        const ArchetypeView* view;
+        size_t archetype;
+        size_t chunk = 0;
+        size_t row = 0;
+        size_t rowsInChunk = 0;
+        EntityID* entities = nullptr;
+        std::tuple<Types*...> columns;
+
+        Iterator(const ArchetypeView& view, size_t archetype) : view(&view), archetype(archetype) { findChunk(); }
+
+        // moves to the first non-empty chunk of matching archetype, starting from current position.
+        void findChunk() {
+            auto& archetypes = view->store->getArchetypes();
+            for (; archetype < archetypes.size(); archetype++, chunk = 0) {
+                auto& current = *archetypes[archetype];
+                if (!view->matches(current) || chunk >= current.chunkCount() || current.rowsInChunk(chunk) == 0) {
+                    continue;
+                }
+
+                rowsInChunk = current.rowsInChunk(chunk);
+                entities = current.entities(chunk);
+                view->columnsOf(current, chunk, columns, std::index_sequence_for<Types...>());
+                return;
+            }
+
+            chunk = 0;
+        }
+
+        friend class ArchetypeView;
+    };
+
+    // types never registered in the store(see ArchetypeStore::typeID) match no archetype, so the view is empty.
+    explicit ArchetypeView(const ArchetypeStore& store) : store(&store), types{{store.typeID<Types>()...}} {}
+
+    Iterator begin() const { return Iterator(*this, 0); }
+    Iterator end() const { return Iterator(*this, store->getArchetypes().size()); }
+
+    // calls function(count, entities, columns...) for every non-empty chunk of matching archetypes.
+    template <typename Function>
+    void forEachChunk(Function&& function) const {
+        for (auto& archetype : store->getArchetypes()) {
+            if (!matches(*archetype)) {
+                continue;
+            }
+
+            for (auto chunk = 0u; chunk < archetype->chunkCount() && archetype->rowsInChunk(chunk) > 0; chunk++) {
+                std::tuple<Types*...> columns;
+                columnsOf(*archetype, chunk, columns, std::index_sequence_for<Types...>());
+                function(archetype->rowsInChunk(chunk), archetype->entities(chunk), std::get<Types*>(columns)...);
+            }
+        }
+    }
+
+   private:
+    const ArchetypeStore* store;
+    std::array<size_t, sizeof...(Types)> types;
+
+    bool matches(const Archetype& archetype) const {
+        for (auto type : types) {
+            if (!archetype.has(type)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <size_t... Indices>
+    void columnsOf(Archetype& archetype, size_t chunk, std::tuple<Types*...>& columns,
+                   std::index_sequence<Indices...>) const {
+        columns = std::tuple<Types*...>((Types*)archetype.columnData(chunk, archetype.column(types[Indices]))...);
+    }
+};
+}
@@ -0,0 +1,120 @@
+#include "commandBuffer.h"
+#include <atomic>
+#include <limits>
+#include "entityManager.h"
+#include "entity.h"
+
+using namespace EECS;
+
+bool CommandBuffer::empty() const {
+    if (pendingEntities > 0 || !deletedEntities.empty()) {
+        return false;
+    }
+
+    for (const auto& pending : components) {
+        if (pending && !pending->empty()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void CommandBuffer::clear() {
+    pendingEntities = 0;
+    deletedEntities.clear();
+    for (auto& pending : components) {
+        if (pending) {
+            pending->clear();
+        }
+    }
+}
+
+void CommandBuffer::playback(EntityManager& entities, ComponentManager& components) {
+    playback(std::vector<CommandBuffer*>{this}, entities, components);
+}
+
+void CommandBuffer::playback(const std::vector<CommandBuffer*>& buffers, EntityManager& entities,
+                             ComponentManager& components) {
+    // commands of each type are gathered in the first buffer which has any of them
+    std::vector<PendingComponentsBase*> gathered;
+    std::vector<EntityID> createdEntities;
+
+    for (auto buffer : buffers) {
+        createdEntities.clear();
+        for (auto i = 0u; i < buffer->pendingEntities; i++) {
+            createdEntities.push_back(entities.addEntity().getID());
+        }
+
+        if (gathered.size() < buffer->components.size()) {
+            gathered.resize(buffer->components.size(), nullptr);
+        }
+
+        for (auto type = 0u; type < buffer->components.size(); type++) {
+            auto& pending = buffer->components[type];
+            if (!pending || pending->empty()) {
+                continue;
+            }
+
+            if (!gathered[type]) {
+                gathered[type] = pending.get();
+            }
+            pending->resolveInto(*gathered[type], createdEntities);
+        }
+    }
+
+    for (auto pending : gathered) {
+        if (pending) {
+            pending->addAll(components);
+        }
+    }
+
+    for (auto pending : gathered) {
+        if (pending) {
+            pending->deleteAll(components);
+        }
+    }
+
+    for (auto buffer : buffers) {
+        for (auto entityID : buffer->deletedEntities) {
+            entities.deleteEntity(entityID);
+        }
+        buffer->clear();
+    }
+}
+
+namespace {
+std::atomic<size_t> commandBuffersCount{0};
+
+// buffer used by the thread most recently, to not lock the mutex on each local() call.
+struct LocalBufferCache {
+    size_t ownerID = std::numeric_limits<size_t>::max();
+    CommandBuffer* buffer = nullptr;
+};
+
+thread_local LocalBufferCache localBuffer;
+}
+
+CommandBuffers::CommandBuffers(EntityManager& entities, ComponentManager& components)
+    : entities(entities), components(components), instanceID(commandBuffersCount++) {}
+
+CommandBuffer& CommandBuffers::local() {
+    if (localBuffer.ownerID == instanceID) {
+        return *localBuffer.buffer;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& buffer = buffers[std::this_thread::get_id()];
+    if (!buffer) {
+        buffer = std::make_unique<CommandBuffer>();
+        orderedBuffers.push_back(buffer.get());
+    }
+
+    localBuffer = {instanceID, buffer.get()};
+    return *buffer;
+}
+
+void CommandBuffers::playback() {
+    std::lock_guard<std::mutex> lock(mutex);
+    CommandBuffer::playback(orderedBuffers, entities, components);
+}
@@ -0,0 +1,183 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <cstdint>
+#include "entityID.h"
+#include "componentContainerID.h"
+
+namespace EECS {
+class EntityManager;
+class ComponentManager;
+
+// Entity which will be created when CommandBuffer is played back. Valid only as argument of the buffer which made it.
+struct PendingEntity {
+    uint32_t index;
+};
+
+/** \brief records structural changes(creation and deletion of entities and components) to make them later
+*
+* Components and entities can't be safely added or deleted from concurrently running tasks, or while iterating over
+* components. Such changes can be recorded into a CommandBuffer instead, and played back at a sync point. ECS has
+* CommandBuffers, which gives each thread its own buffer(ecs.commands.local()) and plays all of them back after each
+* TaskScheduler update.
+*
+* Playback is batched, not in recording order: first all entities are created, then components are added, type by type,
+* sorted by entity; then components are deleted, and finally entities are deleted. So deletion wins over addition of
+* the same component, and the last addition of the same component wins over the previous ones.
+*/
+class CommandBuffer {
+   public:
+    PendingEntity createEntity() { return {pendingEntities++}; }
+
+    template <class T, class... Args>
+    void addComponent(EntityID entityID, Args&&... args) {
+        pendingComponents<T>().additions.push_back({{entityID, false}, T(std::forward<Args>(args)...)});
+    }
+
+    template <class T, class... Args>
+    void addComponent(PendingEntity entity, Args&&... args) {
+        pendingComponents<T>().additions.push_back({{entity.index, true}, T(std::forward<Args>(args)...)});
+    }
+
+    template <class T>
+    void deleteComponent(EntityID entityID) {
+        pendingComponents<T>().deletions.push_back(entityID);
+    }
+
+    void deleteEntity(EntityID entityID) { deletedEntities.push_back(entityID); }
+
+    bool empty() const;
+    void clear();
+
+    // makes all recorded changes, then clears the buffer.
+    void playback(EntityManager& entities, ComponentManager& components);
+
+    // plays back all given buffers together, as if everything was recorded into one buffer(in given order).
+    static void playback(const std::vector<CommandBuffer*>& buffers, EntityManager& entities,
+                         ComponentManager& components);
+
+   private:
+    // entity given by EntityID, or by PendingEntity index.
+    struct Target {
+        EntityID entity;
+        bool pending;
+    };
+
+    struct PendingComponentsBase {
+        virtual ~PendingComponentsBase() {}
+
+        virtual bool empty() const = 0;
+        virtual void clear() = 0;
+
+        // replaces pending targets with created entities, then moves all commands to other(of the same type).
+        virtual void resolveInto(PendingComponentsBase& other, const std::vector<EntityID>& createdEntities) = 0;
+
+        virtual void addAll(ComponentManager& components) = 0;
+        virtual void deleteAll(ComponentManager& components) = 0;
+    };
+
+    template <class T>
+    struct PendingComponents : PendingComponentsBase {
+        std::vector<std::pair<Target, T>> additions;
+        std::vector<EntityID> deletions;
+
+        bool empty() const override { return additions.empty() && deletions.empty(); }
+
+        void clear() override {
+            additions.clear();
+            deletions.clear();
+        }
+
+        void resolveInto(PendingComponentsBase& base, const std::vector<EntityID>& createdEntities) override {
+            auto& other = (PendingComponents<T>&)base;
+            for (auto& addition : additions) {
+                if (addition.first.pending) {
+                    addition.first = {createdEntities[addition.first.entity], false};
+                }
+                if (&other != this) {
+                    other.additions.push_back(std::move(addition));
+                }
+            }
+
+            if (&other != this) {
+                other.deletions.insert(other.deletions.end(), deletions.begin(), deletions.end());
+                clear();
+            }
+        }
+
+        // additions are made in bulk, which keeps the last addition of the same component.
+        void addAll(ComponentManager& components) override;
+
+        void deleteAll(ComponentManager& components) override;
+    };
+
+    uint32_t pendingEntities = 0;
+    std::vector<EntityID> deletedEntities;
+    std::vector<std::unique_ptr<PendingComponentsBase>> components;  // indexed by ComponentContainerID
+
+    template <class T>
+    PendingComponents<T>& pendingComponents() {
+        auto id = ComponentContainerID::get<T>();
+        if (components.size() <= id) {
+            components.resize(id + 1);
+        }
+
+        if (!components[id]) {
+            components[id] = std::make_unique<PendingComponents<T>>();
+        }
+
+        return (PendingComponents<T>&)*components[id];
+    }
+};
+
+/** \brief set of CommandBuffers, one per thread which used it
+*
+* Threads record into their own buffers, so recording doesn't need any synchronization apart from the first call of
+* local() on given thread. Playback must not run concurrently with recording.
+*/
+class CommandBuffers {
+   public:
+    CommandBuffers(EntityManager& entities, ComponentManager& components);
+
+    CommandBuffers(const CommandBuffers&) = delete;
+    CommandBuffers& operator=(const CommandBuffers&) = delete;
+
+    // returns buffer of the calling thread.
+    CommandBuffer& local();
+
+    // plays back buffers of all threads together, see CommandBuffer.
+    void playback();
+
+   private:
+    std::mutex mutex;
+    std::unordered_map<std::thread::id, std::unique_ptr<CommandBuffer>> buffers;
+    std::vector<CommandBuffer*> orderedBuffers;  // in order of creation, so playback order is stable
+    EntityManager& entities;
+    ComponentManager& components;
+    const size_t instanceID;
+};
+}
+
+#include "componentManager.h"
+
+namespace EECS {
+template <class T>
+void CommandBuffer::PendingComponents<T>::addAll(ComponentManager& components) {
+    std::vector<EntityID> entityIDs;
+    entityIDs.reserve(additions.size());
+    for (const auto& addition : additions) {
+        entityIDs.push_back(addition.first.entity);
+    }
+
+    components.emplaceBulk<T>(entityIDs, [this](size_t i) { return std::move(additions[i].second); });
+}
+
+template <class T>
+void CommandBuffer::PendingComponents<T>::deleteAll(ComponentManager& components) {
+    components.deleteComponents<T>(deletions);
+}
+}
@@ -3,6 +3,8 @@
 #include "componentContainerID.h"
 #include "globalDefs.h"
 #include "entityID.h"
+#include "componentStorage.h"
+#include "componentSignature.h"
 
 namespace EECS {
 // Used for registering component type in the system.
@@ -11,6 +13,7 @@ template <typename T>
 class ComponentRegistrator {
    public:
     ComponentRegistrator() {
+        // limit of component types is checked when ComponentManager is created, see checkComponentTypeID
         auto id = ComponentContainerID::get<T>();
 
         if (singleComponentContainerArchetypes().size() <= id) {
@@ -40,11 +43,15 @@ class ComponentRegistrator {
 *   }
 * };
 *
+* Components are stored in a vector sorted by entityID by default. Component can pick other storage backend by
+* declaring Storage alias, for ex. `using Storage = SparseSetStorage;`. See componentStorage.h for available backends.
 */
 template <typename Derived>
 struct Component {
     EntityID entityID;
 
+    using Storage = SortedStorage;
+
    private:
     Component() { (void)componentRegistrator; }
 
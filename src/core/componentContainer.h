@@ -3,6 +3,9 @@
 #include <algorithm>
 #include <memory>
 #include "entityID.h"
+#include "componentStorage.h"
+#include "archetypeStore.h"
+#include "../utils/span.h"
 
 namespace EECS {
 
@@ -16,31 +19,33 @@ class ComponentContainerBase {
 
     virtual bool cloneComponent(EntityID sourceEntity, EntityID recipientEntity) = 0;
     virtual bool genericDeleteComponent(EntityID entity) = 0;
+
+    // called by ComponentManager with its ArchetypeStore. Used only by containers with ArchetypeStorage backend.
+    virtual void setArchetypeStore(ArchetypeStore&) {}
 };
 
-// Template class used for storing components of particular type.
-template <class T>
+// Template class used for storing components of particular type. Components are kept in backend chosen by component
+// type(T::Storage), see componentStorage.h.
+template <class T, class StorageTag = typename T::Storage>
 class ComponentContainer : public ComponentContainerBase {
    public:
-    // returns pointer to a component owned by given entity, in O(lg n). nullptr if component doesn't exist.
-    T* getComponent(EntityID entityID) {
-        auto componentIt =
-            std::lower_bound(components.begin(), components.end(), entityID,
-                             [](const T& component, EntityID entityID) { return component.entityID < entityID; });
+    // type returned by getComponent and addComponent.
+    using Pointer = T*;
 
-        if (componentIt == components.end() || componentIt->entityID != entityID) {
-            return nullptr;
-        }
+    // true if getAllComponents() returns components ordered by entityID.
+    static constexpr bool sorted = ComponentStorage<T, typename T::Storage>::sorted;
 
-        return &*componentIt;
-    }
+    // returns pointer to a component owned by given entity, in O(lg n) or O(1), depending on the backend.
+    // nullptr if component doesn't exist.
+    T* getComponent(EntityID entityID) { return storage.get(entityID); }
 
     // Returns all components held by this class. It's fast method, through dangerous. User shouldn't modify
     // the vector in any way, otherwise class invariants could be invalidated. It's not const vector because then
     // modifying components itself would be impossible, which would render this method useless. If user wants to
     // batch process every/most of components, it's much faster than getting them one by one with getComponent. If user
     // don't know exact entity id, then it's only viable method to do so.
-    std::vector<T>& getAllComponents() { return components; }
+    // Components are contiguous regardless of the backend, but ordered by entityID only if *sorted* is true.
+    std::vector<T>& getAllComponents() { return storage.all(); }
 
     // adds new component, replaces existing component if already exists. Arguments after EntityID will be passed
     // directly to component's constructor. Returns pointer to created component.
@@ -50,19 +55,14 @@ class ComponentContainer : public ComponentContainerBase {
             return nullptr;
         }
 
-        auto place =
-            std::lower_bound(components.begin(), components.end(), entityID,
-                             [](const T& component, EntityID entityID) { return component.entityID < entityID; });
-
-        auto componentAlreadyExists = place != components.end() && place->entityID == entityID;
-        if (componentAlreadyExists) {
-            *place = T(std::forward<Args>(args)...);
-        } else {
-            place = components.insert(place, T(std::forward<Args>(args)...));
-        }
+        return storage.add(entityID, std::forward<Args>(args)...);
+    }
 
-        place->entityID = entityID;
-        return &*place;
+    // adds components to all given entities at once, replacing existing ones. factory(i) returns component for
+    // entityIDs[i], and can be called in any order. Much faster than separate additions for sorted storage.
+    template <class Factory>
+    void addComponents(Span<const EntityID> entityIDs, Factory&& factory) {
+        storage.addBulk(entityIDs, std::forward<Factory>(factory));
     }
 
     // copies component from one entity to another. Returns true if component was cloned, otherwise false.
@@ -72,43 +72,118 @@ class ComponentContainer : public ComponentContainerBase {
             return false;
         }
 
-        auto targetComponent = addComponent(recipientEntity);
-        if (!targetComponent) {
-            return false;
-        }
-
-        *targetComponent = *sourceComponent;
-        targetComponent->entityID = recipientEntity;
+        // addition can relocate source component, so it must be copied beforehand.
+        T clone = *sourceComponent;
+        return addComponent(recipientEntity, std::move(clone)) != nullptr;
+    }
 
-        return true;
+    // Checks if pointer to the component is still valid, in very fast way.
+    bool validComponentPointer(T* componentPtr, EntityID entityID) {
+        return validPointer(storage, componentPtr, entityID);
     }
 
     // Deletes component of a given Entity. Returns true if deleted, false if it doesn't exist in the first place.
-    bool deleteComponent(EntityID entityID) {
-        auto componentIt =
-            std::lower_bound(components.begin(), components.end(), entityID,
-                             [](const T& component, EntityID entityID) { return component.entityID < entityID; });
-
-        if (componentIt != components.end() && componentIt->entityID == entityID) {
-            components.erase(componentIt);
-            return true;
-        }
+    bool deleteComponent(EntityID entityID) { return storage.remove(entityID); }
 
-        return false;
-    }
+    // deletes components of all given entities at once. Returns number of deleted components.
+    size_t deleteComponents(Span<const EntityID> entityIDs) { return storage.removeBulk(entityIDs); }
 
     // used internally as a method to delete all components from given entity.
     bool genericDeleteComponent(EntityID entityID) override { return deleteComponent(entityID); }
 
     // Deletes all components
-    void clear() override { components.clear(); }
+    void clear() override { storage.clear(); }
 
     // returns new object of the same class as *this*.
     std::unique_ptr<ComponentContainerBase> getNewClassInstance() const override {
         return std::make_unique<ComponentContainer<T>>();
     }
 
+    void setArchetypeStore(ArchetypeStore& store) override { bindArchetypeStore(storage, store); }
+
    private:
-    std::vector<T> components;
+    ComponentStorage<T, typename T::Storage> storage;
+
+    // components in contiguous storage are valid as long as they're still in it and belong to the same entity.
+    template <class Storage>
+    static bool validPointer(Storage& storage, T* componentPtr, EntityID entityID) {
+        auto& comps = storage.all();
+        return !comps.empty() && &comps.front() <= componentPtr && componentPtr <= &comps.back() &&
+               componentPtr->entityID == entityID;
+    }
+
+    static bool validPointer(ComponentStorage<T, ArchetypeStorage>& storage, T* componentPtr, EntityID entityID) {
+        return componentPtr && storage.get(entityID) == componentPtr;
+    }
+
+    template <class Storage>
+    static void bindArchetypeStore(Storage&, ArchetypeStore&) {}
+
+    static void bindArchetypeStore(ComponentStorage<T, ArchetypeStorage>& storage, ArchetypeStore& store) {
+        storage.setStore(store);
+    }
 };
+
+template <class T, class StorageTag>
+constexpr bool ComponentContainer<T, StorageTag>::sorted;
+
+// Container of components stored with SoAStorage. There are no component objects, so components are accessed through
+// SoAComponentRef, or in bulk through columns.
+template <class T>
+class ComponentContainer<T, SoAStorage> : public ComponentContainerBase {
+   public:
+    using Pointer = SoAComponentRef<T>;
+
+    static constexpr bool sorted = false;
+
+    SoAComponentRef<T> getComponent(EntityID entityID) { return storage.get(entityID); }
+
+    // returns columns of all components. Like getAllComponents of other containers, rows must not be added or removed
+    // through it other than by this container's methods.
+    ComponentStorage<T, SoAStorage>& getColumns() { return storage; }
+
+    template <typename... Args>
+    SoAComponentRef<T> addComponent(EntityID entityID, Args&&... args) {
+        if (entityID == 0) {
+            return nullptr;
+        }
+
+        return storage.add(entityID, std::forward<Args>(args)...);
+    }
+
+    // adds components to all given entities at once, replacing existing ones. factory(i) returns component for
+    // entityIDs[i], and can be called in any order. Same as separate additions, which are O(1).
+    template <class Factory>
+    void addComponents(Span<const EntityID> entityIDs, Factory&& factory) {
+        storage.addBulk(entityIDs, std::forward<Factory>(factory));
+    }
+
+    bool cloneComponent(EntityID sourceEntity, EntityID recipientEntity) override {
+        auto source = getComponent(sourceEntity);
+        if (!source) {
+            return false;
+        }
+
+        return (bool)addComponent(recipientEntity, source.load());
+    }
+
+    bool deleteComponent(EntityID entityID) { return storage.remove(entityID); }
+
+    // deletes components of all given entities at once. Returns number of deleted components.
+    size_t deleteComponents(Span<const EntityID> entityIDs) { return storage.removeBulk(entityIDs); }
+
+    bool genericDeleteComponent(EntityID entityID) override { return deleteComponent(entityID); }
+
+    void clear() override { storage.clear(); }
+
+    std::unique_ptr<ComponentContainerBase> getNewClassInstance() const override {
+        return std::make_unique<ComponentContainer<T>>();
+    }
+
+   private:
+    ComponentStorage<T, SoAStorage> storage;
+};
+
+template <class T>
+constexpr bool ComponentContainer<T, SoAStorage>::sorted;
 }
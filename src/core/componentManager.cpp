@@ -3,8 +3,12 @@
 
 using namespace EECS;
 
+constexpr size_t ComponentManager::intersectionChunkSize;
+
 void ComponentManager::setEntityManager(const EntityManager& entityManager) { this->entityManager = &entityManager; }
 
+void ComponentManager::setJobSystem(JobSystem& jobSystem) { this->jobSystem = &jobSystem; }
+
 bool ComponentManager::entityExists(EntityID entity) {
     if (entityManager) {
         return entityManager->entityExists(entity);
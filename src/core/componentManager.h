@@ -1,14 +1,25 @@
 #pragma once
 #include <memory>
-#include <thread>
-#include <mutex>
+#include <algorithm>
+#include <iterator>
+#include <tuple>
 #include <unordered_map>
 #include <type_traits>
+#include <stdexcept>
+#include <string>
 #include "componentContainer.h"
 #include "entityID.h"
 #include "globalDefs.h"
 #include "componentContainerID.h"
 #include "component.h"
+#include "jobSystem.h"
+#include "componentView.h"
+#include "joinCursor.h"
+#include "archetypeStore.h"
+#include "archetypeView.h"
+#include "componentSignature.h"
+#include "profiler.h"
+#include "../utils/typeName.h"
 
 namespace EECS {
 class EntityManager;
@@ -68,33 +79,104 @@ class IntersectionComponents {
 // Stores all components in the system. Provides facilities to add, delete, and get components by various methods.
 class ComponentManager {
    public:
+    // Throws std::length_error if there are more component types than EECS_MAX_COMPONENT_TYPES.
     ComponentManager() {
         containers.reserve(singleComponentContainerArchetypes().size());
         for (const auto& container : singleComponentContainerArchetypes()) {
+            checkComponentTypeID(containers.size());
             containers.emplace_back(container->getNewClassInstance());
+            containers.back()->setArchetypeStore(archetypes);
         }
     }
 
+    // ComponentSignature has room for maxComponentTypes types only, so component type with greater ID can't be used.
+    static void checkComponentTypeID(size_t componentTypeID) {
+        if (componentTypeID >= maxComponentTypes) {
+            throw std::length_error("component type ID " + std::to_string(componentTypeID) +
+                                    " is over the limit of component types(" + std::to_string(maxComponentTypes) +
+                                    "), increase EECS_MAX_COMPONENT_TYPES");
+        }
+    }
+
+    // containers of archetype-stored types point into archetypes, so ComponentManager stays where it was created.
+    ComponentManager(const ComponentManager&) = delete;
+    ComponentManager& operator=(const ComponentManager&) = delete;
+    ComponentManager(ComponentManager&&) = delete;
+    ComponentManager& operator=(ComponentManager&&) = delete;
+
     // Returns ComponentHandle to the created component. If it failed to create new component, handle will point to
     //  nullptr. Arguments after entityID are forwarded to constructor of the created component.
+    // For types stored with SoAStorage, SoAComponentRef is returned instead.
     template <class T, class... Args>
-    ComponentHandle<T> addComponent(EntityID entityID, Args&&... args) {
+    auto addComponent(EntityID entityID, Args&&... args) {
+        using Pointer = typename ComponentContainer<T>::Pointer;
         if (!entityExists(entityID)) {
-            return ComponentHandle<T>(*this, nullptr);
+            return makeHandle(Pointer(nullptr));
+        }
+
+        auto component = getContainer<T>()->addComponent(entityID, std::forward<Args>(args)...);
+        if (component) {
+            mutableSignature(entityID).set(ComponentContainerID::get<T>());
+        }
+        return makeHandle(component);
+    }
+
+    // Adds components to all given entities at once. factory(i) returns component for entityIDs[i]; it can be called
+    // in any order. Nonexistent entities are skipped. For sorted storage it's a single sort of the new batch and merge
+    // with the old components, instead of shifting them on each addition.
+    template <class T, class Factory>
+    void emplaceBulk(Span<const EntityID> entityIDs, Factory&& factory) {
+        std::vector<size_t> existing;
+        for (auto i = 0u; i < entityIDs.size(); i++) {
+            if (entityIDs[i] != 0 && entityExists(entityIDs[i])) {
+                existing.push_back(i);
+            }
+        }
+
+        auto type = ComponentContainerID::get<T>();
+        for (auto i : existing) {
+            mutableSignature(entityIDs[i]).set(type);
+        }
+
+        if (existing.size() == entityIDs.size()) {
+            getContainer<T>()->addComponents(entityIDs, std::forward<Factory>(factory));
+            return;
         }
 
-        auto componentPtr = getContainer<T>()->addComponent(entityID, std::forward<Args>(args)...);
-        return ComponentHandle<T>(*this, componentPtr);
+        std::vector<EntityID> existingIDs;
+        existingIDs.reserve(existing.size());
+        for (auto i : existing) {
+            existingIDs.push_back(entityIDs[i]);
+        }
+        getContainer<T>()->addComponents(existingIDs, [&](size_t i) { return factory(existing[i]); });
+    }
+
+    // Adds the same component, constructed from args, to all given entities at once, see emplaceBulk.
+    template <class T, class... Args>
+    void addComponents(Span<const EntityID> entityIDs, const Args&... args) {
+        emplaceBulk<T>(entityIDs, [&](size_t) { return T(args...); });
+    }
+
+    // Deletes components owned by all given entities in a single pass. Returns number of deleted components.
+    template <class T>
+    size_t deleteComponents(Span<const EntityID> entityIDs) {
+        for (auto entityID : entityIDs) {
+            resetSignatureBit(entityID, ComponentContainerID::get<T>());
+        }
+        return getContainer<T>()->deleteComponents(entityIDs);
     }
 
     // Deletes component owned by given entity. Returns true if it was deleted, false if it didn't exist.
     template <class T>
     bool deleteComponent(EntityID entityID) {
+        resetSignatureBit(entityID, ComponentContainerID::get<T>());
         return getContainer<T>()->deleteComponent(entityID);
     }
 
     // Deletes all components
     void clear() {
+        archetypes.clear();
+        signatures.clear();
         for (auto& container : containers) {
             container->clear();
         }
@@ -103,19 +185,38 @@ class ComponentManager {
     // Deletes all *T* components.
     template <class T>
     void clear() {
+        for (auto& signature : signatures) {
+            signature.components.reset(ComponentContainerID::get<T>());
+        }
         getContainer<T>()->clear();
     }
 
+    // true if entity has components of all given types. Single test of entity's ComponentSignature, so it's cheaper
+    // than getting components, for ex. to filter out entities before more expensive queries.
+    template <class... Types>
+    bool hasComponents(EntityID entityID) const {
+        const auto& required = signatureOf<Types...>();
+        return (getSignature(entityID) & required) == required;
+    }
+
+    // returns set of component types which given entity has.
+    const ComponentSignature& getSignature(EntityID entityID) const {
+        static const ComponentSignature empty;
+        auto index = entityIndex(entityID);
+        return index < signatures.size() && signatures[index].entity == entityID ? signatures[index].components : empty;
+    }
+
     // returns pointer to component of type T, owned by entity specified by argument, or nullptr if it doesn't exists.
+    // For types stored with SoAStorage, returns SoAComponentRef.
     template <class T>
-    T* getComponent(EntityID entityID) {
+    typename ComponentContainer<T>::Pointer getComponent(EntityID entityID) {
         return getContainer<T>()->getComponent(entityID);
     }
 
     // the same as getComponent, but returns ComponentHandle instead.
     template <class T>
-    ComponentHandle<T> getComponentHandle(EntityID entityID) {
-        return ComponentHandle<T>(*this, getComponent<T>(entityID));
+    auto getComponentHandle(EntityID entityID) {
+        return makeHandle(getComponent<T>(entityID));
     }
 
     // returns reference to container which contains all components of type T. This container should not be modified in
@@ -126,6 +227,17 @@ class ComponentManager {
         return getContainer<T>()->getAllComponents();
     }
 
+    // returns columns of all components of type T stored with SoAStorage, see SoAColumns. For ex.
+    // auto& positions = comps.columns<PositionComponent>();
+    // auto xs = positions.column(&PositionComponent::x);
+    // auto velocities = positions.column(&PositionComponent::velocityX);
+    // for (auto i = 0u; i < positions.size(); i++) xs[i] += velocities[i];
+    template <class T>
+    ComponentStorage<T, SoAStorage>& columns() {
+        static_assert(std::is_same<typename T::Storage, SoAStorage>::value, "T isn't stored with SoAStorage");
+        return getContainer<T>()->getColumns();
+    }
+
     // given list of types, gets all entities which have *at least* these types and returns vector of convenient
     // helper classes that allow for access/modification of these types. Each element of vector corresponds to single
     // entity.
@@ -136,62 +248,173 @@ class ComponentManager {
     // components could be accessed like that:
     // comps.intersection<PositionComponent, MovementComponent>()[0].get<PositionComponent>().x = 5;
     // Order of Entities in returned vector is undefined.
+    //
+    // Query is driven by the smallest of the containers. If all of them are sorted, it's a linear merge join, which
+    // gallops through bigger containers; otherwise other components are looked up for each entity of the smallest one.
+    // If JobSystem is set, big queries are split into chunks processed in parallel.
+    //
+    // Types with ArchetypeStorage are queried by scanning chunks of matching archetypes instead.
     template <typename Head, typename... Tail>
     std::vector<IntersectionComponents<Head, Tail...>> intersection() {
-        auto& headComponents = getAllComponents<Head>();
+        static_assert(!UsesSoAStorage<Head, Tail...>::value,
+                      "Use columns<T>() to process types stored with SoAStorage");
+        EECS_PROFILE_ZONE("query", (typeName<Head, Tail...>()));
+        return intersection<Head, Tail...>(UsesArchetypeStorage<Head, Tail...>());
+    }
+
+    // returns lazy range over all entities which have *at least* given component types, yielding tuple of references to
+    // their components. Doesn't allocate; see ComponentView(or ArchetypeView, for archetype-stored types) for details.
+    // for (auto components : comps.view<PositionComponent, MovementComponent>()) {
+    //     std::get<PositionComponent&>(components).x = 5;
+    // }
+    template <typename Head, typename... Tail>
+    auto view() {
+        static_assert(!UsesSoAStorage<Head, Tail...>::value,
+                      "Use columns<T>() to process types stored with SoAStorage");
+        return view<Head, Tail...>(UsesArchetypeStorage<Head, Tail...>());
+    }
+
+    // Checks if pointer to the component is still valid, in very fast way. Pointer to the component could turn invalid
+    // if there was any addiction/deletion of any component which is the same type(or, for archetype-stored types, any
+    // archetype-stored component of the same entity).
+    template <class T>
+    bool validComponentPointer(T* componentPtr, EntityID entityID) {
+        static_assert(!UsesSoAStorage<T>::value,
+                      "Components stored with SoAStorage have no pointers, use getComponent(returns SoAComponentRef)");
+        return getContainer<T>()->validComponentPointer(componentPtr, entityID);
+    }
+
+    void setEntityManager(const EntityManager& entityManager);
+
+    // Sets JobSystem used to parallelize queries. Without it, all queries are done on the calling thread.
+    void setJobSystem(JobSystem& jobSystem);
+
+   private:
+    // number of Head components processed by single job in parallel intersection.
+    static constexpr size_t intersectionChunkSize = 1024;
+
+    struct EntitySignature {
+        EntityID entity = 0;
+        ComponentSignature components;
+    };
+
+    std::vector<std::unique_ptr<ComponentContainerBase>> containers;
+    std::vector<EntitySignature> signatures;  // indexed by entityIndex
+    ArchetypeStore archetypes;
+    const EntityManager* entityManager = nullptr;
+    JobSystem* jobSystem = nullptr;
+    bool entityExists(EntityID entity);
+
+    // returns signature of given entity, for modification. Signature left by entity which previously occupied the same
+    // index is reset.
+    ComponentSignature& mutableSignature(EntityID entityID) {
+        auto index = entityIndex(entityID);
+        if (index >= signatures.size()) {
+            signatures.resize(index + 1);
+        }
+
+        auto& signature = signatures[index];
+        if (signature.entity != entityID) {
+            signature.entity = entityID;
+            signature.components.reset();
+        }
+
+        return signature.components;
+    }
+
+    void resetSignatureBit(EntityID entityID, size_t type) {
+        auto index = entityIndex(entityID);
+        if (index < signatures.size() && signatures[index].entity == entityID) {
+            signatures[index].components.reset(type);
+        }
+    }
+
+    // true_type if all given types use ArchetypeStorage, false_type if none of them does.
+    template <typename... Types>
+    struct UsesArchetypeStorage
+        : std::integral_constant<bool, allOf({std::is_same<typename Types::Storage, ArchetypeStorage>::value...})> {
+        static_assert(UsesArchetypeStorage::value ||
+                          allOf({!std::is_same<typename Types::Storage, ArchetypeStorage>::value...}),
+                      "Query can't mix components using ArchetypeStorage with components using other storages");
+    };
+
+    // true_type if any of given types uses SoAStorage.
+    template <typename... Types>
+    using UsesSoAStorage =
+        std::integral_constant<bool, !allOf({!std::is_same<typename Types::Storage, SoAStorage>::value...})>;
+
+    template <class T>
+    ComponentHandle<T> makeHandle(T* component) {
+        return ComponentHandle<T>(*this, component);
+    }
+
+    template <class T>
+    SoAComponentRef<T> makeHandle(SoAComponentRef<T> component) {
+        return component;
+    }
 
+    // archetype-stored components are already grouped, so it's just a copy of matching chunks' columns.
+    template <typename Head, typename... Tail>
+    std::vector<IntersectionComponents<Head, Tail...>> intersection(std::true_type) {
+        using expand = int[];
         std::vector<IntersectionComponents<Head, Tail...>> results;
-        results.reserve(headComponents.size());
-        std::mutex resultsMutex;
-
-        auto worker = [&](size_t startIndex, size_t endIndex) {
-            for (auto i = startIndex; i <= endIndex; i++) {
-                IntersectionComponents<Head, Tail...> currentEntityRequiredComponents;
-                if (fillWithRequiredComponents<IntersectionComponents<Head, Tail...>, Tail...>(
-                        headComponents[i].entityID, currentEntityRequiredComponents)) {
-                    currentEntityRequiredComponents.set(headComponents[i]);
-                    currentEntityRequiredComponents.entityID = headComponents[i].entityID;
-                    std::lock_guard<std::mutex> guard(resultsMutex);
-                    results.push_back(currentEntityRequiredComponents);
+
+        ArchetypeView<Head, Tail...>(archetypes)
+            .forEachChunk([&results](size_t count, EntityID* entities, Head* head, Tail*... tail) {
+                for (auto i = 0u; i < count; i++) {
+                    IntersectionComponents<Head, Tail...> entityComponents;
+                    entityComponents.entityID = entities[i];
+                    entityComponents.set(head[i]);
+                    (void)expand{0, (entityComponents.set(tail[i]), 0)...};
+                    results.push_back(entityComponents);
                 }
-            }
-        };
+            });
 
-        size_t elemsPerThread = headComponents.size() / 8;
+        return results;
+    }
 
-        if (elemsPerThread < 3) {
-            worker(0, headComponents.size() - 1);
+    template <typename Head, typename... Tail>
+    std::vector<IntersectionComponents<Head, Tail...>> intersection(std::false_type) {
+        using Result = IntersectionComponents<Head, Tail...>;
+
+        size_t sizes[] = {getAllComponents<Head>().size(), getAllComponents<Tail>().size()...};
+        auto driver = (size_t)(std::min_element(std::begin(sizes), std::end(sizes)) - std::begin(sizes));
+        auto driverSize = sizes[driver];
+
+        std::vector<Result> results;
+        if (!jobSystem || jobSystem->workerCount() == 0 || driverSize <= intersectionChunkSize) {
+            joinRange<Head, Tail...>(driver, 0, driverSize, results);
             return results;
         }
 
-        std::vector<std::thread> threads;
-        for (auto i = 0; i < 8; i++) {
-            threads.push_back(std::thread{worker, elemsPerThread * i, elemsPerThread * (i + 1) - 1});
+        // each chunk gathers results on its own, so workers don't contend; then they're concatenated in chunk order.
+        std::vector<std::vector<Result>> chunkResults((driverSize + intersectionChunkSize - 1) / intersectionChunkSize);
+        jobSystem->parallelFor(0, driverSize, intersectionChunkSize, [&](size_t begin, size_t end) {
+            joinRange<Head, Tail...>(driver, begin, end, chunkResults[begin / intersectionChunkSize]);
+        });
+
+        size_t resultsCount = 0;
+        for (const auto& chunk : chunkResults) {
+            resultsCount += chunk.size();
         }
-        threads.push_back(
-            std::thread{worker, headComponents.size() - headComponents.size() % 8, headComponents.size() - 1});
 
-        for (auto& thread : threads) {
-            thread.join();
+        results.reserve(resultsCount);
+        for (const auto& chunk : chunkResults) {
+            results.insert(results.end(), chunk.begin(), chunk.end());
         }
 
         return results;
     }
 
-    // Checks if pointer to the component is still valid, in very fast way. Pointer to the component could turn invalid
-    // if there was any addiction/deletion of any component which is the same type.
-    template <class T>
-    bool validComponentPointer(T* componentPtr, EntityID entityID) {
-        auto& comps = getAllComponents<T>();
-        return &comps.front() <= componentPtr && componentPtr <= &comps.back() && componentPtr->entityID == entityID;
+    template <typename Head, typename... Tail>
+    ComponentView<Head, Tail...> view(std::false_type) {
+        return ComponentView<Head, Tail...>(getContainer<Head>(), getContainer<Tail>()...);
     }
 
-    void setEntityManager(const EntityManager& entityManager);
-
-   private:
-    std::vector<std::unique_ptr<ComponentContainerBase>> containers;
-    const EntityManager* entityManager = nullptr;
-    bool entityExists(EntityID entity);
+    template <typename Head, typename... Tail>
+    ArchetypeView<Head, Tail...> view(std::true_type) {
+        return ArchetypeView<Head, Tail...>(archetypes);
+    }
 
     template <class T>
     ComponentContainer<T>* getContainer() {
@@ -199,6 +422,69 @@ class ComponentManager {
         return (ComponentContainer<T>*)containers[ComponentContainerID::get<T>()].get();
     }
 
+    // returns entityID of index-th component of *driver*-th type from Types.
+    template <typename... Types>
+    EntityID entityIDAt(size_t driver, size_t index) {
+        using Accessor = EntityID (*)(ComponentManager&, size_t);
+        static const Accessor accessors[] = {
+            [](ComponentManager& manager, size_t index) {
+                return manager.getAllComponents<Types>()[index].entityID;
+            }...};
+        return accessors[driver](*this, index);
+    }
+
+    template <class T>
+    JoinCursor<T> makeJoinCursor(EntityID first, EntityID last, bool bounded) {
+        auto& components = getAllComponents<T>();
+        auto byEntity = [](const T& component, EntityID entityID) { return component.entityID < entityID; };
+
+        auto begin = std::lower_bound(components.begin(), components.end(), first, byEntity);
+        auto end = bounded ? std::lower_bound(begin, components.end(), last, byEntity) : components.end();
+        return {components.data() + (begin - components.begin()), components.data() + (end - components.begin())};
+    }
+
+    // Appends to results all entities which have all Types, among the ones owning driver components [begin, end).
+    template <typename... Types>
+    void joinRange(size_t driver, size_t begin, size_t end, std::vector<IntersectionComponents<Types...>>& results) {
+        using expand = int[];
+        constexpr bool allSorted = allOf({ComponentContainer<Types>::sorted...});
+        if (begin >= end) {
+            return;
+        }
+
+        if (!allSorted) {
+            for (auto i = begin; i < end; i++) {
+                IntersectionComponents<Types...> entityComponents;
+                entityComponents.entityID = entityIDAt<Types...>(driver, i);
+                if (hasComponents<Types...>(entityComponents.entityID) &&
+                    fillWithRequiredComponents<IntersectionComponents<Types...>, Types...>(entityComponents.entityID,
+                                                                                           entityComponents)) {
+                    results.push_back(entityComponents);
+                }
+            }
+            return;
+        }
+
+        // merge join over entityID ranges corresponding to the driver chunk
+        auto first = entityIDAt<Types...>(driver, begin);
+        auto bounded = end < getSizeOf<Types...>(driver);
+        auto last = bounded ? entityIDAt<Types...>(driver, end) : 0;
+        std::tuple<JoinCursor<Types>...> cursors(makeJoinCursor<Types>(first, last, bounded)...);
+
+        while (alignJoinCursors(cursors)) {
+            IntersectionComponents<Types...> entityComponents;
+            entityComponents.entityID = std::get<0>(cursors).position->entityID;
+            (void)expand{0, (entityComponents.set(*std::get<JoinCursor<Types>>(cursors).position++), 0)...};
+            results.push_back(entityComponents);
+        }
+    }
+
+    template <typename... Types>
+    size_t getSizeOf(size_t typeIndex) {
+        size_t sizes[] = {getAllComponents<Types>().size()...};
+        return sizes[typeIndex];
+    }
+
     // Fills second argument with required components. Returns true if all required components belonging to given entity
     // were found
     template <typename IntersectComponents, typename Head, typename... Tail>
@@ -0,0 +1,29 @@
+#pragma once
+#include <bitset>
+#include <cstddef>
+#include "componentContainerID.h"
+
+// Maximum number of component types, can be overridden by compiler flag. Determines size of ComponentSignature.
+#ifndef EECS_MAX_COMPONENT_TYPES
+#define EECS_MAX_COMPONENT_TYPES 256
+#endif
+
+namespace EECS {
+constexpr size_t maxComponentTypes = EECS_MAX_COMPONENT_TYPES;
+
+// Set of component types, indexed by ComponentContainerID. ComponentManager keeps one for each entity.
+using ComponentSignature = std::bitset<maxComponentTypes>;
+
+// returns signature with bits of given types set. Computed once per set of types.
+template <typename... ComponentTypes>
+const ComponentSignature& signatureOf() {
+    static const ComponentSignature signature = []() {
+        ComponentSignature signature;
+        using expand = int[];
+        (void)expand{0, (signature.set(ComponentContainerID::get<ComponentTypes>()), 0)...};
+        return signature;
+    }();
+
+    return signature;
+}
+}
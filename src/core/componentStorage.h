@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include "entityID.h"
+#include "../utils/span.h"
+
+namespace EECS {
+// Storage backends of component containers. Component type selects one by shadowing Storage alias, which is declared
+// in Component base, for ex.
+//
+// struct PositionComponent : Component<PositionComponent> {
+//     using Storage = SparseSetStorage;
+//     float x, y;
+// };
+
+// Components are kept in a vector sorted by entityID. Lookup is O(lg n), addition and deletion O(n). Default backend.
+struct SortedStorage {};
+
+// Components are kept in densely packed, unordered vector, with paged entity -> index table on the side.
+// Lookup, addition and deletion are O(1). Deletion moves last component into freed place.
+struct SparseSetStorage {};
+
+// Components of all types using this backend are stored together, grouped by archetypes(sets of such component
+// types owned by an entity), in fixed-size chunks with one column per type - see ArchetypeStore. Lookup is O(1);
+// addition and deletion move entity's components to other archetype. Queries are linear scans over matching chunks.
+// getAllComponents() isn't available for such types, and queries can't mix them with types using other backends.
+struct ArchetypeStorage {};
+
+// Each field listed in component's Fields alias(see FieldList) is stored in its own aligned column, so kernels touching
+// only some fields don't drag the rest through cache. Lookup, addition and deletion are O(1). Component objects don't
+// exist in such storage: getComponent returns SoAComponentRef instead of a pointer, and components are processed
+// through ComponentManager::columns<T>() rather than views and intersections. Fields not on the list aren't stored.
+struct SoAStorage {};
+
+// Implementation of the storage, specialized for each backend tag.
+template <class T, class StorageTag>
+class ComponentStorage;
+
+// Bulk operations of backends whose additions and deletions are O(1): just loops over single ones. Storage derives
+// from it and may shadow reserveAdditional to preallocate room for added components.
+template <class Storage>
+class LoopedBulkOperations {
+   public:
+    // factory(i) returns component for entityIDs[i].
+    template <class Factory>
+    void addBulk(Span<const EntityID> entityIDs, Factory&& factory) {
+        auto& storage = static_cast<Storage&>(*this);
+        storage.reserveAdditional(entityIDs.size());
+        for (auto i = 0u; i < entityIDs.size(); i++) {
+            storage.add(entityIDs[i], factory(i));
+        }
+    }
+
+    size_t removeBulk(Span<const EntityID> entityIDs) {
+        auto& storage = static_cast<Storage&>(*this);
+        size_t deletedCount = 0;
+        for (auto entityID : entityIDs) {
+            deletedCount += storage.remove(entityID);
+        }
+        return deletedCount;
+    }
+
+    void reserveAdditional(size_t) {}
+};
+}
+
+#include "sortedComponentStorage.h"
+#include "sparseSetComponentStorage.h"
+#include "archetypeComponentStorage.h"
+#include "soaComponentStorage.h"
@@ -0,0 +1,137 @@
+#pragma once
+#include <tuple>
+#include <iterator>
+#include <cstddef>
+#include "componentContainer.h"
+#include "entityID.h"
+#include "joinCursor.h"
+
+namespace EECS {
+/** \brief lazy, non-owning range of entities which have *at least* all given component types
+*
+* Unlike ComponentManager::intersection it doesn't gather results anywhere, so it doesn't allocate. Matching entities
+* are found while iterating. If all containers are sorted, it's a merge join galloping through all of them; otherwise
+* it walks through Head components and looks up Tail components of the same entity.
+* Each element is a tuple of references to the components, so it can be used like that:
+*
+* for (auto components : comps.view<PositionComponent, VelocityComponent>()) {
+*     std::get<PositionComponent&>(components).x += std::get<VelocityComponent&>(components).x;
+* }
+*
+* Iterator also gives entity which the components belong to:
+*
+* auto view = comps.view<PositionComponent, VelocityComponent>();
+* for (auto it = view.begin(); it != view.end(); ++it) {
+*     log(it.entity(), std::get<0>(*it).x);
+* }
+*
+* Adding or deleting components of viewed types while iterating invalidates iterators.
+*/
+template <typename Head, typename... Tail>
+class ComponentView {
+    using Cursors = std::tuple<JoinCursor<Head>, JoinCursor<Tail>...>;
+    static constexpr bool mergeJoin = allOf({ComponentContainer<Head>::sorted, ComponentContainer<Tail>::sorted...});
+
+   public:
+    using Components = std::tuple<Head&, Tail&...>;
+
+    class Iterator {
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Components;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Components;
+
+        Components operator*() const { return Components(*std::get<Head*>(current), *std::get<Tail*>(current)...); }
+
+        EntityID entity() const { return std::get<Head*>(current)->entityID; }
+
+        Iterator& operator++() {
+            using expand = int[];
+            if (mergeJoin) {
+                (void)expand{0, (std::get<JoinCursor<Head>>(cursors).position++, 0),
+                             (std::get<JoinCursor<Tail>>(cursors).position++, 0)...};
+            } else {
+                std::get<JoinCursor<Head>>(cursors).position++;
+            }
+
+            findMatch();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            auto previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const Iterator& other) const { return headPosition() == other.headPosition(); }
+        bool operator!=(const Iterator& other) const { return headPosition() != other.headPosition(); }
+
+       private:
+        const ComponentView* view;
+        Cursors cursors;
+        std::tuple<Head*, Tail*...> current;
+
+        Iterator(const ComponentView& view, Cursors cursors) : view(&view), cursors(cursors) { findMatch(); }
+
+        Head* headPosition() const { return std::get<JoinCursor<Head>>(cursors).position; }
+
+        // moves forward to the first entity which has all viewed components, or to the end.
+        void findMatch() {
+            auto& head = std::get<JoinCursor<Head>>(cursors);
+
+            if (mergeJoin) {
+                if (!alignJoinCursors(cursors)) {
+                    head.position = head.end;
+                    return;
+                }
+
+                std::get<Head*>(current) = head.position;
+                using expand = int[];
+                (void)expand{0, (std::get<Tail*>(current) = std::get<JoinCursor<Tail>>(cursors).position, 0)...};
+                return;
+            }
+
+            for (; !head.exhausted(); head.position++) {
+                if (findTail(head.position->entityID)) {
+                    std::get<Head*>(current) = head.position;
+                    return;
+                }
+            }
+        }
+
+        bool findTail(EntityID entityID) {
+            bool found = true;
+            using expand = int[];
+            (void)expand{0, (found = found && (std::get<Tail*>(current) = std::get<ComponentContainer<Tail>*>(
+                                                                                view->containers)
+                                                                                ->getComponent(entityID)) != nullptr,
+                             0)...};
+            return found;
+        }
+
+        friend class ComponentView;
+    };
+
+    ComponentView(ComponentContainer<Head>* head, ComponentContainer<Tail>*... tail) : containers(head, tail...) {}
+
+    Iterator begin() const { return Iterator(*this, Cursors(cursorOf<Head>(), cursorOf<Tail>()...)); }
+
+    Iterator end() const {
+        auto endCursors = Cursors(cursorOf<Head>(), cursorOf<Tail>()...);
+        std::get<JoinCursor<Head>>(endCursors).position = std::get<JoinCursor<Head>>(endCursors).end;
+        return Iterator(*this, endCursors);
+    }
+
+   private:
+    std::tuple<ComponentContainer<Head>*, ComponentContainer<Tail>*...> containers;
+
+    template <class T>
+    JoinCursor<T> cursorOf() const {
+        auto& components = std::get<ComponentContainer<T>*>(containers)->getAllComponents();
+        return {components.data(), components.data() + components.size()};
+    }
+};
+}
@@ -4,27 +4,102 @@
 
 using namespace EECS;
 
-EECS::ECS::ECS(const std::string& configFilename) : entities(components), tasks(*this) {
+EECS::ECS::ECS(const std::string& configFilename) : entities(components), commands(entities, components), tasks(*this) {
     components.setEntityManager(entities);
+    components.setJobSystem(jobs);
 
     if (!configFilename.empty()) {
         config.load(configFilename);
     }
+
+    events.setMaxCascadeRounds(config.get("events.maxCascadeRounds", 8u));
+    events.setOrdered(config.get("events.ordered", false));
+    events.setTickDuration(std::chrono::microseconds(config.get("events.tickMicroseconds", 1000u)));
+    pacer.setMode(FramePacer::parseMode(config.get("loop.pacing", "sleep")));
+    pacer.setSpinThreshold(std::chrono::microseconds(config.get("loop.spinMicroseconds", 1000u)));
+    if (config.get("loop.wakeOnEvents", true)) {
+        events.setWakeSignal(&wakeup);
+        pacer.setWakeSignal(&wakeup);
+    }
+    tasks.setFrameBudget(std::chrono::microseconds(config.get("loop.frameBudgetMicroseconds", 0u)));
+    jobs.start(config.get("jobs.workerCount", std::max(1u, std::thread::hardware_concurrency()) - 1));
 }
 
+EECS::ECS::~ECS() { tasks.clear(); }
+
 void EECS::ECS::run() {
     Timer timer;
-    std::chrono::milliseconds elapsedTime{0};
+    std::chrono::nanoseconds elapsedTime{0};
 
     while (!quit) {
-        auto durationUntilNextUpdateNecessary = tasks.update(elapsedTime);
-        auto timeSpentSinceLastUpdate = Timer{};
+        EECS_PROFILE_FRAME();
+        if (recorder) {
+            recorder->frame(elapsedTime);
+        }
+
+        events.advance(elapsedTime);
+        // without tasks, update returns maximum duration; loop still wakes up now and then to notice stop()
+        auto untilNextUpdate = std::min<std::chrono::nanoseconds>(tasks.update(elapsedTime), std::chrono::seconds(1));
+        auto nextUpdate = FramePacer::Clock::now() + untilNextUpdate;
 
+        // events pushed so far are emitted now, so they don't need to wake the loop up; neither do events pushed by
+        // receivers during emit, but if cascade rounds ran out, some of them may still wait
+        wakeup.reset();
         events.emit();
 
-        std::this_thread::sleep_for(durationUntilNextUpdateNecessary - timeSpentSinceLastUpdate.elapsed());
-        elapsedTime = std::max(std::chrono::milliseconds(0), timer.reset());
+        // triggered tasks and leftover events are handled in the next iteration right away, scheduled events when
+        // they're due
+        if (!quit && !events.hasPending() && !tasks.hasTriggeredTasks()) {
+            auto now = FramePacer::Clock::now();
+            if (events.untilNextScheduled() < nextUpdate - now) {
+                nextUpdate = now + events.untilNextScheduled();
+            }
+            pacer.waitUntil(nextUpdate);
+        }
+        elapsedTime = timer.reset();
     }
 }
 
-void EECS::ECS::stop() { quit = true; }
+void EECS::ECS::stop() {
+    quit = true;
+    wakeup.notify();
+}
+
+void EECS::ECS::startRecording(std::ostream& output) {
+    stopRecording();
+    recorder = std::make_unique<EventLogWriter>(output);
+    events.startRecording(*recorder);
+}
+
+void EECS::ECS::stopRecording() {
+    events.stopRecording();
+    recorder.reset();
+}
+
+size_t EECS::ECS::replay(std::istream& input) {
+    EventLogReader log(input);
+    size_t frames = 0;
+
+    events.setReplaying(true);
+    while (log.next()) {
+        const auto& record = log.record();
+        if (record.type != EventLogRecord::Type::Frame) {
+            if (!events.replay(record)) {
+                break;
+            }
+            continue;
+        }
+
+        events.finishReplayedRound();
+        events.advance(record.elapsed);
+        tasks.update(record.elapsed);
+        frames++;
+    }
+
+    // events which weren't taken by any recorded round, like non-recordable ones left after the final frame, are
+    // delivered before replaying ends; recordable ones are still dropped, as their recorded counterparts were replayed
+    events.finishReplayedRound();
+    events.emit();
+    events.setReplaying(false);
+    return frames;
+}
@@ -1,34 +1,70 @@
 #pragma once
+#include <atomic>
+#include <memory>
+#include <istream>
+#include <ostream>
 #include "../utils/config.h"
 #include "componentManager.h"
 #include "entityManager.h"
 #include "taskScheduler.h"
 #include "eventQueue.h"
+#include "jobSystem.h"
+#include "commandBuffer.h"
+#include "framePacer.h"
 
 namespace EECS {
 /** class that encapsulates whole ECS
 *
 * It ties all components together and manages it's configuration.
-* It measures delta time for TaskScheduler.
+* It measures delta time for TaskScheduler, and moves time of events scheduled in EventQueue.
+* Between updates main loop waits through FramePacer, set up by loop.pacing("sleep", "hybrid" or "spin") and
+* loop.spinMicroseconds settings. loop.frameBudgetMicroseconds(0 by default, meaning no budget) sets frame budget of
+* TaskScheduler, over which low priority tasks are deferred.
+* Main loop sleeps until the next task or scheduled event is due. With loop.wakeOnEvents(true by default), pushing an
+* event from any thread wakes it up earlier, so event driven tasks(see TriggeredBy) run right after the event is
+* emitted.
+* When built with EECS_PROFILER, each iteration of main loop is marked as a frame of Profiler.
+* It owns JobSystem shared by engine internals and Tasks, sized by jobs.workerCount setting.
+* Structural changes recorded into commands are made after each update of TaskScheduler.
+*
+* Session can be recorded into a binary EventLog - time passed to each update and all recordable events emitted - and
+* replayed later, at full speed, against an ECS set up the same way(same build, same tasks and receivers). That allows
+* reproducing real sessions as benchmarks.
 */
 class ECS {
    public:
     ECS(const std::string& configFilename = "");
 
+    // Tasks are deleted first, so they can disconnect from events.
+    ~ECS();
+
     // Runs main loop. Calls TaskScheduler::update periodically, feeding it with delta time.
     void run();
 
-    // Will stop main loop at the next iteration.
+    // Will stop main loop at the next iteration. Can be called from any thread.
     void stop();
 
+    // Starts writing frames and events of the main loop to the stream, until stopRecording. Stream must outlive it.
+    void startRecording(std::ostream& output);
+    void stopRecording();
+
+    // Replays recorded session: for each recorded frame, updates TaskScheduler with recorded time and emits recorded
+    // events, without waiting. Returns number of replayed frames; stops early at malformed record.
+    size_t replay(std::istream& input);
+
+    JobSystem jobs;
     ComponentManager components;
     EntityManager entities;
+    CommandBuffers commands;
     TaskScheduler tasks;
     EventQueue events;
+    FramePacer pacer;
 
     Configuration config;
 
    private:
-    bool quit = false;
+    std::atomic<bool> quit{false};
+    WakeSignal wakeup;
+    std::unique_ptr<EventLogWriter> recorder;
 };
 }
@@ -2,5 +2,14 @@
 #include <cstdint>
 
 namespace EECS {
+// Entity identifier. Lower 32 bits are index of the entity slot, upper 32 bits are generation of that slot. Slots are
+// reused after entity deletion, with generation incremented, so stale identifiers of deleted entities don't refer to
+// the new ones. 0(index 0, generation 0) is null entity and never refers to existing entity.
 using EntityID = uint64_t;
+
+inline uint32_t entityIndex(EntityID entityID) { return (uint32_t)entityID; }
+
+inline uint32_t entityGeneration(EntityID entityID) { return (uint32_t)(entityID >> 32); }
+
+inline EntityID makeEntityID(uint32_t index, uint32_t generation) { return ((EntityID)generation << 32) | index; }
 }
@@ -5,8 +5,17 @@ namespace EECS {
 Entity EntityManager::getEntity(EntityID entityID) { return {entityID, *this, componentManager}; }
 
 Entity EntityManager::addEntity() {
-    entityExistence[++lastEntity] = true;
-    return {lastEntity, *this, componentManager};
+    uint32_t index;
+    if (!freeSlots.empty()) {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        index = (uint32_t)slots.size();
+        slots.emplace_back();
+    }
+
+    slots[index].alive = true;
+    return {makeEntityID(index, slots[index].generation), *this, componentManager};
 }
 
 Entity EntityManager::cloneEntity(EntityID source) {
@@ -16,9 +25,12 @@ Entity EntityManager::cloneEntity(EntityID source) {
 
     Entity target = addEntity();
 
-    for (auto& container : componentManager.containers) {
-        if (container) {
-            container->cloneComponent(source, target);
+    // only containers of types which source has are visited
+    auto signature = componentManager.getSignature(source);
+    auto& targetSignature = componentManager.mutableSignature(target);
+    for (auto type = 0u; type < componentManager.containers.size(); type++) {
+        if (signature.test(type) && componentManager.containers[type]->cloneComponent(source, target)) {
+            targetSignature.set(type);
         }
     }
 
@@ -26,24 +38,35 @@ Entity EntityManager::cloneEntity(EntityID source) {
 }
 
 bool EntityManager::deleteEntity(EntityID entityID) {
-    auto it = entityExistence.find(entityID);
-    if (it == entityExistence.end()) {
+    if (!entityExists(entityID)) {
         return false;
     }
 
-    for (auto& container : componentManager.containers) {
-        container->genericDeleteComponent(entityID);
+    auto signature = componentManager.getSignature(entityID);
+    for (auto type = 0u; type < componentManager.containers.size(); type++) {
+        if (signature.test(type)) {
+            componentManager.containers[type]->genericDeleteComponent(entityID);
+        }
+    }
+    componentManager.mutableSignature(entityID).reset();
+
+    auto index = entityIndex(entityID);
+    auto& slot = slots[index];
+    slot.alive = false;
+
+    // when generation wraps around, slot is retired for good - otherwise very old identifiers could become valid again.
+    if (++slot.generation != 0) {
+        freeSlots.push_back(index);
     }
 
-    entityExistence.erase(it);
     return true;
 }
 
 void EntityManager::clear() {
-    for (auto entityEntry : entityExistence) {
-        deleteEntity(entityEntry.first);
+    for (auto index = 1u; index < slots.size(); index++) {
+        if (slots[index].alive) {
+            deleteEntity(makeEntityID(index, slots[index].generation));
+        }
     }
-
-    entityExistence.clear();
 }
 }
@@ -1,15 +1,22 @@
 #pragma once
-#include <unordered_map>
+#include <vector>
+#include <cstdint>
 #include "componentManager.h"
 
 namespace EECS {
 class Entity;
 
+// Creates and destroys entities. Entity slots are kept in a dense array, and slots of deleted entities are reused
+// (most recently freed first), with generation bumped so identifiers of deleted entities stay invalid.
 class EntityManager {
    public:
-    explicit EntityManager(ComponentManager& componentManager) : componentManager(componentManager) {}
+    explicit EntityManager(ComponentManager& componentManager) : slots(1), componentManager(componentManager) {}
 
-    bool entityExists(EntityID entityID) const { return entityExistence.find(entityID) != entityExistence.end(); }
+    // O(1), single array lookup. Stale identifiers(of deleted entities, even if their slot was reused) yield false.
+    bool entityExists(EntityID entityID) const {
+        auto index = entityIndex(entityID);
+        return index < slots.size() && slots[index].alive && slots[index].generation == entityGeneration(entityID);
+    }
 
     Entity getEntity(EntityID entityID);
 
@@ -20,8 +27,13 @@ class EntityManager {
     void clear();
 
    private:
-    std::unordered_map<EntityID, bool> entityExistence;
-    EntityID lastEntity = 0;
+    struct EntitySlot {
+        uint32_t generation = 0;
+        bool alive = false;
+    };
+
+    std::vector<EntitySlot> slots;  // slot 0 is reserved for null entity
+    std::vector<uint32_t> freeSlots;
     ComponentManager& componentManager;
 };
 }
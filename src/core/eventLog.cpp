@@ -0,0 +1,97 @@
+#include "eventLog.h"
+#include <cstring>
+
+using namespace EECS;
+
+constexpr uint32_t EventLogRecord::maxPayloadSize;
+constexpr size_t EventLogWriter::bufferSize;
+
+namespace {
+const char magic[8] = {'E', 'E', 'C', 'S', 'L', 'O', 'G', '1'};
+}
+
+EventLogWriter::EventLogWriter(std::ostream& output) : output(output) {
+    buffer.reserve(bufferSize);
+    append(magic, sizeof(magic));
+}
+
+EventLogWriter::~EventLogWriter() { flush(); }
+
+void EventLogWriter::frame(std::chrono::nanoseconds elapsed) {
+    append(EventLogRecord::Type::Frame);
+    append<int64_t>(elapsed.count());
+}
+
+void EventLogWriter::round() { append(EventLogRecord::Type::Round); }
+
+void EventLogWriter::event(uint32_t eventID, const void* payload, uint32_t size) {
+    append(EventLogRecord::Type::Event);
+    append(eventID);
+    append(size);
+    append(payload, size);
+}
+
+void EventLogWriter::targetedEvent(uint32_t eventID, EntityID target, const void* payload, uint32_t size) {
+    append(EventLogRecord::Type::TargetedEvent);
+    append(eventID);
+    append(size);
+    append(target);
+    append(payload, size);
+}
+
+void EventLogWriter::flush() {
+    output.write(buffer.data(), buffer.size());
+    output.flush();
+    buffer.clear();
+}
+
+void EventLogWriter::append(const void* data, size_t size) {
+    if (buffer.size() + size > bufferSize) {
+        flush();
+    }
+
+    auto position = buffer.size();
+    buffer.resize(position + size);
+    std::memcpy(buffer.data() + position, data, size);
+}
+
+EventLogReader::EventLogReader(std::istream& input) : input(input) {
+    char header[sizeof(magic)];
+    headerValid = input.read(header, sizeof(header)) && std::memcmp(header, magic, sizeof(magic)) == 0;
+}
+
+bool EventLogReader::next() {
+    if (!headerValid || !read(current.type)) {
+        return false;
+    }
+
+    switch (current.type) {
+        case EventLogRecord::Type::Frame: {
+            int64_t elapsed;
+            if (!read(elapsed)) {
+                return false;
+            }
+            current.elapsed = std::chrono::nanoseconds(elapsed);
+            return true;
+        }
+        case EventLogRecord::Type::Round:
+            return true;
+        case EventLogRecord::Type::Event:
+        case EventLogRecord::Type::TargetedEvent: {
+            uint32_t size;
+            if (!read(current.eventID) || !read(size) || size > EventLogRecord::maxPayloadSize) {
+                return false;
+            }
+
+            current.target = 0;
+            if (current.type == EventLogRecord::Type::TargetedEvent && !read(current.target)) {
+                return false;
+            }
+
+            current.payload.resize(size);
+            return (bool)input.read(current.payload.data(), size);
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include "entityID.h"
+
+namespace EECS {
+/** \brief binary log of frames and events, written by ECS while recording and read back when replaying
+*
+* Log starts with a magic header, followed by records, each starting with a type byte:
+* - Frame: time(in nanoseconds, int64) passed to TaskScheduler::update;
+* - Round: start of a cascade round of EventQueue::emit;
+* - Event, TargetedEvent: EventID(uint32), payload size(uint32), target EntityID(uint64, TargetedEvent only) and bytes
+*   of the event.
+* Numbers are stored in native byte order. EventIDs depend on the binary, so logs can only be replayed by the same build
+* which recorded them.
+*/
+struct EventLogRecord {
+    enum class Type : uint8_t { Frame = 'F', Round = 'R', Event = 'E', TargetedEvent = 'T' };
+
+    // bigger events aren't recorded, and reader treats bigger payload size as corruption.
+    static constexpr uint32_t maxPayloadSize = 64 * 1024;
+
+    Type type;
+    std::chrono::nanoseconds elapsed{0};  // Frame only
+    uint32_t eventID = 0;                 // Event and TargetedEvent only
+    EntityID target = 0;                  // TargetedEvent only
+    std::vector<char> payload;            // Event and TargetedEvent only
+};
+
+// Writes records to the stream through an internal buffer, so recording costs mostly a memcpy per event.
+class EventLogWriter {
+   public:
+    static constexpr size_t bufferSize = 64 * 1024;
+
+    EventLogWriter(std::ostream& output);
+    ~EventLogWriter();
+
+    EventLogWriter(const EventLogWriter&) = delete;
+    EventLogWriter& operator=(const EventLogWriter&) = delete;
+
+    void frame(std::chrono::nanoseconds elapsed);
+    void round();
+    void event(uint32_t eventID, const void* payload, uint32_t size);
+    void targetedEvent(uint32_t eventID, EntityID target, const void* payload, uint32_t size);
+
+    // writes buffered records to the stream.
+    void flush();
+
+   private:
+    std::ostream& output;
+    std::vector<char> buffer;
+
+    void append(const void* data, size_t size);
+
+    template <class T>
+    void append(T value) {
+        append(&value, sizeof(value));
+    }
+};
+
+class EventLogReader {
+   public:
+    // reads and checks the header. If it's wrong, reader is invalid and next() always returns false.
+    EventLogReader(std::istream& input);
+
+    bool valid() const { return headerValid; }
+
+    // reads the next record. Returns false at the end of the log, or if the record is malformed or truncated. Payload
+    // size is checked before anything is allocated for it.
+    bool next();
+
+    // the last record read by next().
+    const EventLogRecord& record() const { return current; }
+
+   private:
+    std::istream& input;
+    bool headerValid;
+    EventLogRecord current;
+
+    template <class T>
+    bool read(T& value) {
+        return (bool)input.read((char*)&value, sizeof(value));
+    }
+};
+}
@@ -2,7 +2,12 @@
 #include <memory>
 #include <algorithm>
 #include <type_traits>
+#include <chrono>
+#include <cstdint>
+#include <limits>
 #include "singleEventQueue.h"
+#include "timingWheel.h"
+#include "wakeSignal.h"
 #include "globalDefs.h"
 #include "event.h"
 
@@ -14,6 +19,25 @@ namespace EECS {
 *
 * receiver method returns true if event is to spread further into
 * lower-priority receivers, or false if it should vanish.
+*
+* Events can also be scheduled to be pushed later, with emitAt and emitAfter. Time is measured in ticks of
+* tickDuration(1ms by default), and moves forward only through advance(ECS::run calls it every iteration). Scheduled
+* events wait in a TimingWheel, so scheduling and cancelling is O(1) regardless of number of pending ones.
+* Scheduling, cancelling and advancing must be done by the thread calling emit.
+*
+* By default events are delivered type by type, so events of different types aren't delivered in order of pushing.
+* In ordered mode(setOrdered, events.ordered setting) all pushed events go to a single EventStream instead, and are
+* delivered in order of pushing, across types: each run of consecutive events of the same type is delivered at once,
+* like a cascade round of its own. That costs a mutex per push and smaller batches, so it's off by default.
+*
+* Event types defining coalesceKey() are coalescing channels: of events with the same key pushed for one cascade round,
+* receivers get only one - the last pushed, or the result of merging them, if the type defines merge(EventType&&).
+* For example:
+*
+* struct TransformChanged : Event<TransformChanged> {
+*     EntityID entity;
+*     EntityID coalesceKey() const { return entity; }
+* };
 */
 class EventQueue {
    public:
@@ -24,13 +48,50 @@ class EventQueue {
         }
     }
 
-    /** \brief emits all events in system at once, type by type. */
-    void emit() {
-        for (auto& eventType : eventQueues) {
-            if (eventType) {
-                eventType->emit();
-            }
-        }
+    ~EventQueue() {
+        clearTimers();
+        clearStream();
+    }
+
+    /** \brief emits all events in system at once, type by type
+    *
+    * Events pushed by receivers are delivered in the next cascade round. Each round first takes all pending events of
+    * all types, then delivers them, so event chains are delivered in deterministic order. Rounds are repeated until no
+    * events are pending, but at most maxCascadeRounds times; the rest waits for the next emit.
+    *
+    * \returns number of rounds that delivered any events.
+    */
+    size_t emit() {
+        EECS_PROFILE_ZONE("events", "EventQueue::emit");
+        // receivers push events on this thread, and those are delivered by this emit or the next one
+        auto& emitting = emittingQueue();
+        auto previous = emitting;
+        emitting = this;
+        auto rounds = ordered ? emitOrdered() : emitByType();
+        emitting = previous;
+        return rounds;
+    }
+
+    /** \brief switches between delivering events type by type, and in order of pushing(see EventQueue)
+    *
+    * Must be switched when no events are pending or being pushed.
+    */
+    void setOrdered(bool ordered) { this->ordered = ordered; }
+
+    bool isOrdered() const { return ordered; }
+
+    /** \brief sets maximum number of cascade rounds per emit, see emit. At least one round is always done. */
+    void setMaxCascadeRounds(size_t rounds) { maxCascadeRounds = std::max<size_t>(1, rounds); }
+    size_t getMaxCascadeRounds() const { return maxCascadeRounds; }
+
+    /** \brief true if any events were pushed, but not delivered yet
+    *
+    * After emit, these are events left over when cascade rounds ran out, or pushed by other threads meanwhile.
+    */
+    bool hasPending() const {
+        return stream.hasPending() || std::any_of(eventQueues.begin(), eventQueues.end(), [](const auto& queue) {
+                   return queue && queue->hasPending();
+               });
     }
 
     /** \brief add existing event object to queue
@@ -41,6 +102,12 @@ class EventQueue {
     */
     template <typename EventType>
     void push(EventType&& event) {
+        wake();
+        if (ordered) {
+            stream.push<EventType>(idOf<EventType>(), false, 0, std::move(event));
+            return;
+        }
+
         getQueue<EventType>()->push(std::move(event));
     }
 
@@ -53,9 +120,32 @@ class EventQueue {
     */
     template <typename EventType, typename... Args>
     void emplace(Args&&... args) {
+        wake();
+        if (ordered) {
+            stream.push<EventType>(idOf<EventType>(), false, 0, std::forward<Args>(args)...);
+            return;
+        }
+
         getQueue<EventType>()->emplace(std::forward<Args>(args)...);
     }
 
+    /** \brief creates new event targeted at given entity
+    *
+    * \param args arguments to be passed to event's constructor
+    *
+    * Event is delivered only to receivers connected to this entity, after untargeted events of the same type.
+    */
+    template <typename EventType, typename... Args>
+    void pushTo(EntityID target, Args&&... args) {
+        wake();
+        if (ordered) {
+            stream.push<EventType>(idOf<EventType>(), true, target, std::forward<Args>(args)...);
+            return;
+        }
+
+        getQueue<EventType>()->emplaceTo(target, std::forward<Args>(args)...);
+    }
+
     /** \brief connect new receiver to particular event type
     *
     * \param receiver object that will receive events of EventType type
@@ -63,10 +153,15 @@ class EventQueue {
     * Receiver can be any class. Only requirment is possessing receive(const EventType&) method.
     * Receiver will be called every time event of this type will be emited. Single class can receive arbitrary
     * amount of event types.
+    * Receiver having receiveBatch(Span<EventType>) method instead gets all emitted events of the type in a single call.
+    * Receiver can also be a callable taking EventType&, like lambda - it's copied into the queue, so it must fit into
+    * SmallFunction. Object receivers are referenced, and connecting the same one again has no effect.
+    *
+    * \returns Subscription, which disconnects the receiver in O(1).
     */
-    template <typename EventType, typename RecieverType>
-    void connect(RecieverType& reciever, int priority = 0) {
-        getQueue<EventType>()->connect(reciever, priority);
+    template <typename EventType, typename Receiver>
+    Subscription connect(Receiver&& receiver, int priority = 0) {
+        return withEventID<EventType>(getQueue<EventType>()->connect(std::forward<Receiver>(receiver), priority));
     }
 
     /** \brief disconnect receiver from particular event type
@@ -80,13 +175,221 @@ class EventQueue {
         getQueue<EventType>()->disconnect(reciever);
     }
 
+    /** \brief disconnect receiver identified by subscription returned by connect
+    *
+    * \returns false if it was already disconnected.
+    */
+    bool disconnect(const Subscription& subscription) {
+        return subscription && subscription.eventID < eventQueues.size() && eventQueues[subscription.eventID] &&
+               eventQueues[subscription.eventID]->disconnect(subscription);
+    }
+
+    /** \brief connect receiver to events of particular type targeted at given entity(see pushTo)
+    *
+    * Subscriptions are kept in an index keyed by EntityID, so receivers of other entities aren't touched when
+    * the event is delivered. They aren't removed when the entity is deleted; use disconnectAll for that.
+    */
+    template <typename EventType, typename Receiver>
+    Subscription connect(EntityID entity, Receiver&& receiver, int priority = 0) {
+        return withEventID<EventType>(
+            getQueue<EventType>()->connect(entity, std::forward<Receiver>(receiver), priority));
+    }
+
+    template <typename EventType, typename RecieverType>
+    void disconnect(EntityID entity, RecieverType& reciever) {
+        getQueue<EventType>()->disconnect(entity, reciever);
+    }
+
+    /** \brief removes all subscriptions to events of particular type targeted at given entity */
+    template <typename EventType>
+    void disconnectAll(EntityID entity) {
+        getQueue<EventType>()->disconnectAll(entity);
+    }
+
+    /** \brief sets the flag whenever emit delivers events of particular type, until removeTrigger
+    *
+    * Flag is set before any receiver gets the events, so receivers stopping propagation don't affect it. Events
+    * targeted at entities(see pushTo) set it too. Used by TriggeredBy.
+    */
+    template <typename EventType>
+    void addTrigger(bool& flag) {
+        getQueue<EventType>()->addTrigger(flag);
+    }
+
+    template <typename EventType>
+    void removeTrigger(bool& flag) {
+        getQueue<EventType>()->removeTrigger(flag);
+    }
+
     template <typename EventType, typename ReceiverType>
     void setPriority(ReceiverType& obj, int priority) {
         getQueue<EventType>()->disconnect(obj);
         getQueue<EventType>()->connect(obj, priority);
     }
 
+    /** \brief writes events delivered by emit to the log, round by round, until stopRecording
+    *
+    * Only trivially copyable events are recorded, as they're written byte by byte, and only up to
+    * EventLogRecord::maxPayloadSize bytes big.
+    */
+    void startRecording(EventLogWriter& log) { recorder = &log; }
+    void stopRecording() { recorder = nullptr; }
+
+    /** \brief switches queue into replaying recorded events
+    *
+    * While replaying, pushed events of recordable types are dropped - their recorded counterparts, which include
+    * events pushed by receivers, are put into rounds by replay instead. Other events are delivered as usual.
+    */
+    void setReplaying(bool replaying) {
+        for (auto& queue : eventQueues) {
+            if (queue) {
+                queue->setReplaying(replaying);
+            }
+        }
+    }
+
+    /** \brief takes Round or Event record from the log
+    *
+    * Round record delivers previous replayed round and starts the next one, Event records fill it.
+    *
+    * \returns false if record couldn't be replayed.
+    */
+    bool replay(const EventLogRecord& record) {
+        if (record.type == EventLogRecord::Type::Round) {
+            finishReplayedRound();
+            for (auto& queue : eventQueues) {
+                if (queue) {
+                    queue->swapBuffers();
+                }
+            }
+
+            // streamed events of recordable types are dropped, like pushed ones
+            if (stream.swap()) {
+                stream.consume([this](const EventStream::Header& header, void* event) {
+                    eventQueues[header.eventID]->takeStreamed(event, header.targeted, header.target);
+                });
+            }
+            replayedRoundOpen = true;
+            return true;
+        }
+
+        if (record.type == EventLogRecord::Type::Frame || !replayedRoundOpen || record.eventID >= eventQueues.size() ||
+            !eventQueues[record.eventID]) {
+            return false;
+        }
+
+        return eventQueues[record.eventID]->replay(record);
+    }
+
+    /** \brief delivers the last replayed round. Called at the end of each replayed frame. */
+    void finishReplayedRound() {
+        if (!replayedRoundOpen) {
+            return;
+        }
+
+        for (auto& queue : eventQueues) {
+            if (queue) {
+                queue->deliver();
+            }
+        }
+        replayedRoundOpen = false;
+    }
+
+    /** \brief creates new event, which will be pushed to queue when time reaches given tick
+    *
+    * Event due at or before current tick is pushed on the next one.
+    *
+    * \returns TimerID, which can be used to cancel the event before it's pushed.
+    */
+    template <typename EventType, typename... Args>
+    TimerID emitAt(uint64_t tick, Args&&... args) {
+        auto eventID = (uint64_t)EventID::value<EventType>();
+        auto slot = getQueue<EventType>()->storeTimed(std::forward<Args>(args)...);
+        return timers.add(tick, eventID << 32 | slot);
+    }
+
+    /** \brief creates new event, which will be pushed to queue after given delay
+    *
+    * Delay is rounded up to whole ticks, counting from the current time, not the last tick - so event is never pushed
+    * early. Event is emitted by the first emit after advance reaches its time.
+    *
+    * \returns TimerID, which can be used to cancel the event before it's pushed.
+    */
+    template <typename EventType, typename Rep, typename Period, typename... Args>
+    TimerID emitAfter(std::chrono::duration<Rep, Period> delay, Args&&... args) {
+        auto sinceTick = std::chrono::duration_cast<std::chrono::nanoseconds>(delay) + sinceLastTick;
+        auto ticks = std::max<int64_t>(0, (sinceTick.count() + tickDuration.count() - 1) / tickDuration.count());
+        return emitAt<EventType>(timers.currentTick() + ticks, std::forward<Args>(args)...);
+    }
+
+    /** \brief cancels event scheduled by emitAt or emitAfter
+    *
+    * \returns false if event was already pushed or cancelled.
+    */
+    bool cancel(TimerID timer) {
+        uint64_t data;
+        if (!timers.cancel(timer, data)) {
+            return false;
+        }
+
+        eventQueues[data >> 32]->dropTimed((uint32_t)data);
+        return true;
+    }
+
+    /** \brief moves time forward, pushing scheduled events which got due, in order of their deadlines
+    *
+    * Time not making up whole tick is carried over to the next call, so ticks don't drift from real time.
+    */
+    void advance(std::chrono::nanoseconds elapsed) {
+        sinceLastTick += elapsed;
+        auto ticks = sinceLastTick.count() / tickDuration.count();
+        sinceLastTick -= ticks * tickDuration;
+        advanceTicks(ticks);
+    }
+
+    void advanceTicks(uint64_t ticks) {
+        timers.advance(ticks, [this](uint64_t data) {
+            if (ordered) {
+                eventQueues[data >> 32]->streamTimed((uint32_t)data, stream, (uint32_t)(data >> 32));
+            } else {
+                eventQueues[data >> 32]->fireTimed((uint32_t)data);
+            }
+        });
+    }
+
+    uint64_t currentTick() const { return timers.currentTick(); }
+
+    // number of events scheduled, but not pushed yet.
+    size_t scheduledCount() const { return timers.size(); }
+
+    // time after which advance pushes the next scheduled event(lower bound, if it's far), maximum if none is scheduled.
+    std::chrono::nanoseconds untilNextScheduled() const {
+        auto ticks = timers.ticksUntilNext();
+        if (ticks > (uint64_t)(std::chrono::nanoseconds::max().count() / tickDuration.count())) {
+            return std::chrono::nanoseconds::max();
+        }
+
+        return tickDuration * (int64_t)ticks - sinceLastTick;
+    }
+
+    /** \brief sets signal notified whenever event is pushed, so thread waiting for events can wake up, or nullptr
+    *
+    * Events pushed during emit by the thread calling it(by receivers, for example) don't notify the signal.
+    */
+    void setWakeSignal(WakeSignal* signal) { wakeSignal = signal; }
+
+    /** \brief sets length of a tick. Events already scheduled keep their deadlines in ticks. */
+    void setTickDuration(std::chrono::nanoseconds duration) {
+        tickDuration = std::max(std::chrono::nanoseconds(1), duration);
+        sinceLastTick = std::chrono::nanoseconds(0);
+    }
+
+    std::chrono::nanoseconds getTickDuration() const { return tickDuration; }
+
+    // deletes pending and scheduled events, and disconnects all receivers.
     void clear() {
+        clearTimers();
+        clearStream();
         for (auto& queue : eventQueues) {
             queue->clear();
         }
@@ -94,6 +397,123 @@ class EventQueue {
 
    private:
     std::vector<std::unique_ptr<SingleEventQueueBase>> eventQueues;
+    size_t maxCascadeRounds = 8;
+
+    EventLogWriter* recorder = nullptr;
+    bool replayedRoundOpen = false;
+
+    bool ordered = false;
+    EventStream stream;
+    WakeSignal* wakeSignal = nullptr;
+
+    TimingWheel timers;
+    std::chrono::nanoseconds tickDuration = std::chrono::milliseconds(1);
+    std::chrono::nanoseconds sinceLastTick{0};
+
+    size_t emitByType() {
+        size_t round = 0;
+        for (; round < maxCascadeRounds; round++) {
+            auto anyPending = false;
+            for (auto& eventType : eventQueues) {
+                if (eventType) {
+                    anyPending = eventType->swapBuffers() || anyPending;
+                }
+            }
+
+            if (!anyPending) {
+                break;
+            }
+
+            if (recorder) {
+                recorder->round();
+                for (auto i = 0u; i < eventQueues.size(); i++) {
+                    if (eventQueues[i]) {
+                        eventQueues[i]->record(*recorder, i);
+                    }
+                }
+            }
+
+            for (auto& eventType : eventQueues) {
+                if (eventType) {
+                    eventType->deliver();
+                }
+            }
+        }
+
+        return round;
+    }
+
+    size_t emitOrdered() {
+        size_t round = 0;
+        for (; round < maxCascadeRounds && stream.swap(); round++) {
+            auto runEventID = noEventID;
+            auto runTargeted = false;
+            stream.consume([&](const EventStream::Header& header, void* event) {
+                if (header.eventID != runEventID || header.targeted != runTargeted) {
+                    deliverRun(runEventID);
+                    runEventID = header.eventID;
+                    runTargeted = header.targeted;
+                }
+                eventQueues[header.eventID]->takeStreamed(event, header.targeted, header.target);
+            });
+            deliverRun(runEventID);
+        }
+
+        return round;
+    }
+
+    // queue which is emitting on the calling thread, if any.
+    static const EventQueue*& emittingQueue() {
+        thread_local const EventQueue* queue = nullptr;
+        return queue;
+    }
+
+    // events pushed on the thread which is emitting don't need to wake it up.
+    void wake() {
+        if (wakeSignal && emittingQueue() != this) {
+            wakeSignal->notify();
+        }
+    }
+
+    // delivers events taken from the stream into queue of given type.
+    void deliverRun(uint32_t eventID) {
+        if (eventID == noEventID) {
+            return;
+        }
+
+        if (recorder) {
+            recorder->round();
+            eventQueues[eventID]->record(*recorder, eventID);
+        }
+        eventQueues[eventID]->deliver();
+    }
+
+    void clearStream() {
+        auto drop = [this](const EventStream::Header& header, void* event) {
+            eventQueues[header.eventID]->dropStreamed(event);
+        };
+        stream.consume(drop);
+        stream.swap();
+        stream.consume(drop);
+    }
+
+    void clearTimers() {
+        timers.clear([this](uint64_t data) { eventQueues[data >> 32]->dropTimed((uint32_t)data); });
+    }
+
+    static constexpr uint32_t noEventID = std::numeric_limits<uint32_t>::max();
+
+    template <typename EventType>
+    static uint32_t idOf() {
+        static_assert(std::is_base_of<Event<EventType>, EventType>::value, "Template parameter is not an event!");
+        return (uint32_t)EventID::value<EventType>();
+    }
+
+    template <typename EventType>
+    static Subscription withEventID(Subscription subscription) {
+        subscription.eventID = idOf<EventType>();
+        return subscription;
+    }
 
     template <typename EventType>
     SingleEventQueue<EventType>* getQueue() {
@@ -0,0 +1,51 @@
+#include "eventStream.h"
+#include <algorithm>
+
+using namespace EECS;
+
+constexpr size_t EventArena::blockSize;
+constexpr size_t EventArena::headerSize;
+constexpr size_t EventStream::eventOffset;
+
+void* EventArena::allocate(size_t bytes) {
+    bytes = (bytes + headerSize - 1) / headerSize * headerSize;
+
+    if (current < blocks.size() && blocks[current].used + headerSize + bytes > blocks[current].capacity) {
+        current++;
+    }
+
+    if (current == blocks.size() || blocks[current].capacity < headerSize + bytes) {
+        auto capacity = std::max(blockSize, headerSize + bytes);
+        auto memory = std::unique_ptr<std::max_align_t[]>(new std::max_align_t[capacity / headerSize]);
+        auto block = Block{std::move(memory), capacity, 0};
+        if (current == blocks.size()) {
+            blocks.push_back(std::move(block));
+        } else {
+            blocks[current] = std::move(block);
+        }
+    }
+
+    auto& block = blocks[current];
+    auto memory = (char*)block.memory.get() + block.used;
+    *(size_t*)memory = bytes;
+    block.used += headerSize + bytes;
+    return memory + headerSize;
+}
+
+void EventArena::reset() {
+    for (auto& block : blocks) {
+        block.used = 0;
+    }
+    current = 0;
+}
+
+bool EventStream::swap() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::swap(back, front);
+    return !front.empty();
+}
+
+bool EventStream::hasPending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !back.empty();
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include "entityID.h"
+
+namespace EECS {
+// Bump allocator over blocks of memory, which are kept when it's reset, so steady use doesn't allocate.
+class EventArena {
+   public:
+    static constexpr size_t blockSize = 64 * 1024;
+
+    // returns memory for given number of bytes, aligned to max_align_t. Allocation never spans blocks; bigger than
+    // blockSize gets its own block.
+    void* allocate(size_t bytes);
+
+    // passes each allocation, in order, to function(void* memory, size_t bytes). Sizes are rounded up to alignment.
+    template <class Function>
+    void forEach(Function&& function) {
+        for (auto block = 0u; block < blocks.size() && block <= current; block++) {
+            auto memory = (char*)blocks[block].memory.get();
+            for (size_t offset = 0; offset < blocks[block].used;) {
+                auto bytes = *(size_t*)(memory + offset);
+                function((void*)(memory + offset + headerSize), bytes);
+                offset += headerSize + bytes;
+            }
+        }
+    }
+
+    // forgets all allocations, keeping the memory.
+    void reset();
+
+    bool empty() const { return blocks.empty() || (current == 0 && blocks[0].used == 0); }
+
+   private:
+    // each allocation is preceded by its size, padded to keep the alignment
+    static constexpr size_t headerSize = sizeof(std::max_align_t);
+
+    struct Block {
+        std::unique_ptr<std::max_align_t[]> memory;
+        size_t capacity;
+        size_t used;
+    };
+
+    std::vector<Block> blocks;
+    size_t current = 0;
+};
+
+/** \brief events of any types, in order of pushing
+*
+* Each event is a record in an EventArena: header with type tag(EventID) and target, followed by the event itself.
+* Pushes, safe from any thread, go to the back arena under a mutex; swap makes them the front one, which is consumed by
+* the thread emitting events, while further pushes go to the other arena. Memory of both is reused, so there's no heap
+* allocation per event.
+*/
+class EventStream {
+   public:
+    struct Header {
+        uint32_t eventID;
+        bool targeted;
+        EntityID target;
+    };
+
+    template <class EventType, class... Args>
+    void push(uint32_t eventID, bool targeted, EntityID target, Args&&... args) {
+        static_assert(alignof(EventType) <= alignof(std::max_align_t), "Over-aligned events can't be streamed");
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto memory = (char*)back.allocate(eventOffset + sizeof(EventType));
+        new (memory) Header{eventID, targeted, target};
+        new (memory + eventOffset) EventType(std::forward<Args>(args)...);
+    }
+
+    // makes pushed events the front ones. Returns false if there are none. Front must be consumed before.
+    bool swap();
+
+    // true if events were pushed since the last swap.
+    bool hasPending() const;
+
+    // passes front events, in order of pushing, to function(const Header&, void* event), which must move from and
+    // destroy the event. Then empties the front.
+    template <class Function>
+    void consume(Function&& function) {
+        front.forEach([&function](void* memory, size_t) {
+            function(*(Header*)memory, (void*)((char*)memory + eventOffset));
+        });
+        front.reset();
+    }
+
+   private:
+    static constexpr size_t eventOffset = (sizeof(Header) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) *
+                                          alignof(std::max_align_t);
+
+    mutable std::mutex mutex;
+    EventArena back;
+    EventArena front;
+};
+}
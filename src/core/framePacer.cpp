@@ -0,0 +1,163 @@
+#include "framePacer.h"
+#include <thread>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#if defined(__linux__)
+#include <time.h>
+#include <cerrno>
+#endif
+
+using namespace EECS;
+
+constexpr size_t JitterHistogram::bucketCount;
+
+namespace {
+// condition variable of WakeSignal wakes up later than clock_nanosleep, so it's waited on only until this long before
+// the deadline, and the rest is slept through as if there was no signal.
+constexpr auto signalSlack = std::chrono::milliseconds(1);
+
+// sleeps until given time, without accumulating error of relative sleeps.
+void sleepUntil(FramePacer::Clock::time_point deadline) {
+#if defined(__linux__)
+    // steady_clock is CLOCK_MONOTONIC on Linux
+    auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch());
+    timespec time;
+    time.tv_sec = (time_t)(sinceEpoch.count() / 1000000000);
+    time.tv_nsec = (long)(sinceEpoch.count() % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr) == EINTR) {
+    }
+#else
+    std::this_thread::sleep_until(deadline);
+#endif
+}
+
+// like above, but returns early, with true, when signal is notified before the last signalSlack of the wait.
+bool sleepUntil(FramePacer::Clock::time_point deadline, WakeSignal* signal) {
+    if (signal && (signal->poll() || (deadline - FramePacer::Clock::now() > signalSlack &&
+                                      signal->waitUntil(deadline - signalSlack)))) {
+        return true;
+    }
+
+    sleepUntil(deadline);
+    return false;
+}
+
+bool spinUntil(FramePacer::Clock::time_point deadline, WakeSignal* signal) {
+    while (FramePacer::Clock::now() < deadline) {
+        if (signal && signal->poll()) {
+            return true;
+        }
+        std::this_thread::yield();
+    }
+
+    return false;
+}
+}
+
+void JitterHistogram::record(std::chrono::nanoseconds duration) {
+    auto microseconds = (uint64_t)std::max<int64_t>(0, duration.count()) / 1000;
+    size_t index = 0;
+    while (microseconds > 0 && index < bucketCount - 1) {
+        microseconds >>= 1;
+        index++;
+    }
+
+    buckets[index]++;
+    total++;
+    sum += duration;
+    maximum = std::max(maximum, duration);
+}
+
+void JitterHistogram::clear() {
+    buckets.fill(0);
+    total = 0;
+    sum = std::chrono::nanoseconds(0);
+    maximum = std::chrono::nanoseconds(0);
+}
+
+std::chrono::nanoseconds JitterHistogram::mean() const {
+    return total == 0 ? std::chrono::nanoseconds(0) : sum / (int64_t)total;
+}
+
+std::chrono::nanoseconds JitterHistogram::percentile(double fraction) const {
+    auto threshold = (size_t)std::ceil(fraction * total);
+    size_t counted = 0;
+    for (auto index = 0u; index < bucketCount; index++) {
+        counted += buckets[index];
+        if (counted >= threshold && counted > 0) {
+            return std::min(bucketLimit(index), maximum);
+        }
+    }
+
+    return maximum;
+}
+
+std::chrono::nanoseconds JitterHistogram::bucketLimit(size_t index) {
+    return std::chrono::microseconds((int64_t)1 << index);
+}
+
+std::string JitterHistogram::toString() const {
+    std::ostringstream result;
+    for (auto index = 0u; index < bucketCount; index++) {
+        if (buckets[index] == 0) {
+            continue;
+        }
+
+        result << "< " << std::setw(10) << bucketLimit(index).count() / 1000 << "us: " << std::setw(8) << buckets[index]
+               << " (" << std::fixed << std::setprecision(2) << 100.0 * buckets[index] / total << "%)\n";
+    }
+
+    result << "mean: " << mean().count() << "ns, max: " << maximum.count() << "ns, samples: " << total << "\n";
+    return result.str();
+}
+
+FramePacer::Mode FramePacer::parseMode(const std::string& name) {
+    if (name == "hybrid") {
+        return Mode::Hybrid;
+    }
+
+    if (name == "spin") {
+        return Mode::Spin;
+    }
+
+    return Mode::Sleep;
+}
+
+bool FramePacer::waitUntil(Clock::time_point deadline) {
+    if (Clock::now() >= deadline) {
+        overruns++;
+        return false;
+    }
+
+    auto woken = false;
+    switch (mode) {
+        case Mode::Sleep:
+            woken = sleepUntil(deadline, wakeSignal);
+            break;
+        case Mode::Hybrid:
+            if (deadline - Clock::now() > spinThreshold) {
+                woken = sleepUntil(deadline - spinThreshold, wakeSignal);
+            }
+            woken = woken || spinUntil(deadline, wakeSignal);
+            break;
+        case Mode::Spin:
+            woken = spinUntil(deadline, wakeSignal);
+            break;
+    }
+
+    if (woken) {
+        wakeups++;
+        return true;
+    }
+
+    histogram.record(Clock::now() - deadline);
+    return false;
+}
+
+void FramePacer::resetStatistics() {
+    histogram.clear();
+    overruns = 0;
+    wakeups = 0;
+}
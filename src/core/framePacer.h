@@ -0,0 +1,95 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "wakeSignal.h"
+
+namespace EECS {
+/** \brief distribution of durations, in buckets of exponentially growing size
+*
+* Bucket 0 counts durations below 1us; bucket i > 0 counts durations in [2^(i-1), 2^i) microseconds. Recording is O(1)
+* and doesn't allocate, so it can run every frame.
+*/
+class JitterHistogram {
+   public:
+    static constexpr size_t bucketCount = 32;
+
+    void record(std::chrono::nanoseconds duration);
+    void clear();
+
+    size_t count() const { return total; }
+    std::chrono::nanoseconds max() const { return maximum; }
+    std::chrono::nanoseconds mean() const;
+
+    // upper bound of the bucket in which given fraction(0..1) of recorded durations ends, like 0.99 for p99.
+    std::chrono::nanoseconds percentile(double fraction) const;
+
+    size_t bucket(size_t index) const { return buckets[index]; }
+
+    // upper bound of durations counted in the bucket.
+    static std::chrono::nanoseconds bucketLimit(size_t index);
+
+    // human-readable table of non-empty buckets, with count and percent of total of each.
+    std::string toString() const;
+
+   private:
+    std::array<size_t, bucketCount> buckets{};
+    size_t total = 0;
+    std::chrono::nanoseconds sum{0};
+    std::chrono::nanoseconds maximum{0};
+};
+
+/** \brief waits until the start of the next frame of the main loop
+*
+* Deadlines are absolute, so time spent computing them isn't added to the wait. Modes:
+* - Sleep: sleeps until the deadline(clock_nanosleep with absolute time, where available). Cheapest, but OS can
+*   wake thread up late, by tens to hundreds of microseconds.
+* - Hybrid: sleeps until spinThreshold before the deadline, then spins, yielding, for the rest.
+* - Spin: spins for the whole wait, keeping a core busy.
+* Lateness of each wake-up(time between deadline and return) is recorded into the jitter histogram. Deadlines which
+* already passed when waiting started are counted as overruns instead.
+*
+* If WakeSignal is set, notifying it ends the wait early(counted as wakeup). Sleeping is done on its condition variable
+* then, except for the last millisecond before the deadline, which is slept as without the signal - so the deadline is
+* kept as precisely, and notification coming in that last millisecond is noticed at the deadline.
+*/
+class FramePacer {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Mode { Sleep, Hybrid, Spin };
+
+    // returns mode named "sleep", "hybrid" or "spin", or Sleep if name is none of these.
+    static Mode parseMode(const std::string& name);
+
+    void setMode(Mode mode) { this->mode = mode; }
+    Mode getMode() const { return mode; }
+
+    void setSpinThreshold(std::chrono::nanoseconds threshold) { spinThreshold = threshold; }
+    std::chrono::nanoseconds getSpinThreshold() const { return spinThreshold; }
+
+    // signal which can interrupt waiting; nullptr(default) disables it.
+    void setWakeSignal(WakeSignal* signal) { wakeSignal = signal; }
+
+    // returns false if deadline was reached, true if wait was interrupted by WakeSignal.
+    bool waitUntil(Clock::time_point deadline);
+
+    const JitterHistogram& getHistogram() const { return histogram; }
+    size_t getOverruns() const { return overruns; }
+    size_t getWakeups() const { return wakeups; }
+
+    // clears histogram, overrun and wakeup counters.
+    void resetStatistics();
+
+   private:
+    Mode mode = Mode::Sleep;
+    std::chrono::nanoseconds spinThreshold = std::chrono::milliseconds(1);
+    WakeSignal* wakeSignal = nullptr;
+
+    JitterHistogram histogram;
+    size_t overruns = 0;
+    size_t wakeups = 0;
+};
+}
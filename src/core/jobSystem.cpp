@@ -0,0 +1,108 @@
+#include "jobSystem.h"
+
+using namespace EECS;
+
+namespace {
+// identifies worker thread of a job system, so jobs submitted from within a job land in worker's own queue.
+thread_local JobSystem* currentJobSystem = nullptr;
+thread_local size_t currentWorker = 0;
+}
+
+void JobSystem::start(size_t workerCount) {
+    stop();
+
+    running = true;
+    for (auto i = 0u; i < workerCount; i++) {
+        queues.emplace_back(std::make_unique<WorkerQueue>());
+    }
+    for (auto i = 0u; i < workerCount; i++) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+void JobSystem::stop() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running = false;
+    }
+    wakeUp.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    workers.clear();
+    queues.clear();
+}
+
+void JobSystem::submit(const std::vector<Job>& jobs) {
+    pendingJobs.fetch_add(jobs.size());
+
+    auto submittedFromWorker = currentJobSystem == this;
+    for (const auto& job : jobs) {
+        auto queueIndex = submittedFromWorker ? currentWorker : nextQueue++ % queues.size();
+        std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+        queues[queueIndex]->jobs.push_back(job);
+    }
+
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    wakeUp.notify_all();
+}
+
+void JobSystem::workerLoop(size_t workerIndex) {
+    currentJobSystem = this;
+    currentWorker = workerIndex;
+
+    while (true) {
+        Job job;
+        if (takeJob(workerIndex, job)) {
+            job.function(job.context, job.begin, job.end);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return !running || pendingJobs > 0; });
+        if (!running && pendingJobs == 0) {
+            return;
+        }
+    }
+}
+
+void JobSystem::waitUntilZero(const std::atomic<size_t>& counter) {
+    auto queueIndex = currentJobSystem == this ? currentWorker : 0;
+
+    while (counter.load(std::memory_order_acquire) != 0) {
+        Job job;
+        if (takeJob(queueIndex, job)) {
+            job.function(job.context, job.begin, job.end);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool JobSystem::takeJob(size_t preferredQueue, Job& job) {
+    {
+        auto& ownQueue = *queues[preferredQueue];
+        std::lock_guard<std::mutex> lock(ownQueue.mutex);
+        if (!ownQueue.jobs.empty()) {
+            job = ownQueue.jobs.back();
+            ownQueue.jobs.pop_back();
+            pendingJobs--;
+            return true;
+        }
+    }
+
+    for (auto i = 1u; i < queues.size(); i++) {
+        auto& victimQueue = *queues[(preferredQueue + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victimQueue.mutex);
+        if (!victimQueue.jobs.empty()) {
+            job = victimQueue.jobs.front();
+            victimQueue.jobs.pop_front();
+            pendingJobs--;
+            return true;
+        }
+    }
+
+    return false;
+}
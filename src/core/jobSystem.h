@@ -0,0 +1,222 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <type_traits>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <queue>
+#include <functional>
+
+namespace EECS {
+/** \brief persistent pool of worker threads executing short jobs
+*
+* Each worker has its own queue of jobs. Worker takes jobs from the back of its own queue, and when it's empty, steals
+* from the front of other workers' queues. Jobs submitted from outside of the pool are distributed round robin.
+*
+* Thread waiting for its jobs to complete(for ex. in parallelFor) doesn't block - it executes pending jobs in the
+* meantime, so parallelFor can be safely nested, and calling thread contributes to the work.
+*
+* With no workers(default constructed or started with 0) all work is done on the calling thread.
+*
+* ECS owns one JobSystem, sized by jobs.workerCount setting(by default number of hardware threads - 1).
+* Tasks can use it through ecs.jobs.
+*/
+class JobSystem {
+   public:
+    JobSystem() = default;
+    explicit JobSystem(size_t workerCount) { start(workerCount); }
+    ~JobSystem() { stop(); }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /** \brief starts given number of worker threads. Previous workers, if any, are stopped first. */
+    void start(size_t workerCount);
+
+    /** \brief finishes all pending jobs and joins worker threads. */
+    void stop();
+
+    size_t workerCount() const { return workers.size(); }
+
+    /** \brief calls function(chunkBegin, chunkEnd) for consecutive chunks of [begin, end) range, in parallel
+    *
+    * \param grainSize maximum size of a single chunk. If 0, range is divided into few chunks per thread.
+    *
+    * Returns when all chunks were processed. Function must not throw.
+    */
+    template <typename Function>
+    void parallelFor(size_t begin, size_t end, size_t grainSize, Function&& function) {
+        if (begin >= end) {
+            return;
+        }
+
+        if (grainSize == 0) {
+            grainSize = std::max<size_t>(1, (end - begin) / ((workerCount() + 1) * 4));
+        }
+
+        if (workers.empty() || end - begin <= grainSize) {
+            for (auto chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize) {
+                function(chunkBegin, std::min(end, chunkBegin + grainSize));
+            }
+            return;
+        }
+
+        using FunctionType = std::remove_reference_t<Function>;
+        std::atomic<size_t> remainingChunks{(end - begin + grainSize - 1) / grainSize};
+        ParallelForContext<FunctionType> context{&function, &remainingChunks};
+
+        std::vector<Job> jobs;
+        jobs.reserve(remainingChunks);
+        for (auto chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize) {
+            jobs.push_back(
+                {&runParallelForChunk<FunctionType>, &context, chunkBegin, std::min(end, chunkBegin + grainSize)});
+        }
+        submit(jobs);
+
+        waitUntilZero(remainingChunks);
+    }
+
+    /** \brief as above, with grain size chosen automatically */
+    template <typename Function>
+    void parallelFor(size_t begin, size_t end, Function&& function) {
+        parallelFor(begin, end, 0, std::forward<Function>(function));
+    }
+
+    /** \brief calls function(node) for every node of a directed acyclic graph, in parallel, but never before it
+    * returned for all of node's predecessors
+    *
+    * \param successors successors[i] lists nodes which can't start before node i is finished. Graph must not have
+    * cycles.
+    *
+    * Without workers, nodes are processed on the calling thread, lower indices first whenever dependencies allow.
+    * Returns when all nodes were processed. Function must not throw.
+    */
+    template <typename Function>
+    void runGraph(const std::vector<std::vector<size_t>>& successors, Function&& function) {
+        auto nodeCount = successors.size();
+        std::unique_ptr<std::atomic<size_t>[]> predecessors(new std::atomic<size_t>[nodeCount]);
+        for (auto node = 0u; node < nodeCount; node++) {
+            predecessors[node] = 0;
+        }
+        for (const auto& nodeSuccessors : successors) {
+            for (auto successor : nodeSuccessors) {
+                predecessors[successor]++;
+            }
+        }
+
+        if (workers.empty()) {
+            std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> ready;
+            for (auto node = 0u; node < nodeCount; node++) {
+                if (predecessors[node] == 0) {
+                    ready.push(node);
+                }
+            }
+
+            while (!ready.empty()) {
+                auto node = ready.top();
+                ready.pop();
+                function(node);
+                for (auto successor : successors[node]) {
+                    if (--predecessors[successor] == 0) {
+                        ready.push(successor);
+                    }
+                }
+            }
+            return;
+        }
+
+        using FunctionType = std::remove_reference_t<Function>;
+        std::atomic<size_t> remainingNodes{nodeCount};
+        GraphContext<FunctionType> context{this, &function, &successors, predecessors.get(), &remainingNodes};
+
+        std::vector<Job> roots;
+        for (auto node = 0u; node < nodeCount; node++) {
+            if (predecessors[node] == 0) {
+                roots.push_back({&runGraphNode<FunctionType>, &context, node, node + 1});
+            }
+        }
+        if (roots.empty()) {
+            return;
+        }
+        submit(roots);
+
+        waitUntilZero(remainingNodes);
+    }
+
+   private:
+    // Job is plain data, so queueing it doesn't allocate anything apart from occasional deque growth.
+    struct Job {
+        void (*function)(void* context, size_t begin, size_t end);
+        void* context;
+        size_t begin;
+        size_t end;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    template <typename Function>
+    struct ParallelForContext {
+        Function* function;
+        std::atomic<size_t>* remainingChunks;
+    };
+
+    template <typename Function>
+    struct GraphContext {
+        JobSystem* jobSystem;
+        Function* function;
+        const std::vector<std::vector<size_t>>* successors;
+        std::atomic<size_t>* predecessors;  // number of unfinished predecessors of each node
+        std::atomic<size_t>* remainingNodes;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::atomic<size_t> pendingJobs{0};
+    std::atomic<size_t> nextQueue{0};
+    bool running = false;
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+
+    template <typename Function>
+    static void runParallelForChunk(void* context, size_t begin, size_t end) {
+        auto parallelForContext = (ParallelForContext<Function>*)context;
+        (*parallelForContext->function)(begin, end);
+        parallelForContext->remainingChunks->fetch_sub(1, std::memory_order_release);
+    }
+
+    // runs node given by begin, then submits successors which have no unfinished predecessors left.
+    template <typename Function>
+    static void runGraphNode(void* context, size_t node, size_t) {
+        auto graph = (GraphContext<Function>*)context;
+        (*graph->function)(node);
+
+        std::vector<Job> ready;
+        for (auto successor : (*graph->successors)[node]) {
+            if (graph->predecessors[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                ready.push_back({&runGraphNode<Function>, context, successor, successor + 1});
+            }
+        }
+        if (!ready.empty()) {
+            graph->jobSystem->submit(ready);
+        }
+
+        // context may be gone as soon as the last node is counted down, so it must be the last access.
+        graph->remainingNodes->fetch_sub(1, std::memory_order_release);
+    }
+
+    void submit(const std::vector<Job>& jobs);
+    void workerLoop(size_t workerIndex);
+    void waitUntilZero(const std::atomic<size_t>& counter);
+
+    // takes job from given queue first, then tries to steal from other queues. Returns false if there was none.
+    bool takeJob(size_t preferredQueue, Job& job);
+};
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <tuple>
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include "entityID.h"
+
+namespace EECS {
+// constexpr conjunction of the values, used to check properties of all types of a query.
+constexpr bool allOf(std::initializer_list<bool> values) {
+    for (auto value : values) {
+        if (!value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Position in a range of components sorted by entityID, used by merge joins of several component types.
+template <class T>
+struct JoinCursor {
+    T* position;
+    T* end;
+
+    bool exhausted() const { return position == end; }
+
+    // moves forward to the first component with entityID >= given one. Gallops(doubles the step until it goes past the
+    // target, then binary searches the last step), so skipping k components costs O(lg k).
+    void seek(EntityID entityID) {
+        if (position == end || position->entityID >= entityID) {
+            return;
+        }
+
+        size_t step = 1;
+        auto low = position;  // low->entityID < entityID is invariant
+        while (step < (size_t)(end - low) && low[step].entityID < entityID) {
+            low += step;
+            step *= 2;
+        }
+
+        auto high = step < (size_t)(end - low) ? low + step : end;
+        auto precedes = [](const T& component, EntityID entityID) { return component.entityID < entityID; };
+        position = std::lower_bound(low + 1, high, entityID, precedes);
+    }
+};
+
+// Leapfrog join step: moves cursors forward until all of them point at components of the same entity, then returns
+// true, or until any of them is exhausted, then returns false. Cursors already aligned are left as they are.
+template <typename... Types>
+bool alignJoinCursors(std::tuple<JoinCursor<Types>...>& cursors) {
+    using expand = int[];
+
+    while (true) {
+        auto exhausted = false;
+        (void)expand{0, (exhausted = exhausted || std::get<JoinCursor<Types>>(cursors).exhausted(), 0)...};
+        if (exhausted) {
+            return false;
+        }
+
+        EntityID target = 0;
+        (void)expand{0, (target = std::max(target, std::get<JoinCursor<Types>>(cursors).position->entityID), 0)...};
+        (void)expand{0, (std::get<JoinCursor<Types>>(cursors).seek(target), 0)...};
+
+        auto aligned = true;
+        (void)expand{0, (aligned = aligned && !std::get<JoinCursor<Types>>(cursors).exhausted() &&
+                                   std::get<JoinCursor<Types>>(cursors).position->entityID == target,
+                         0)...};
+        if (aligned) {
+            return true;
+        }
+    }
+}
+}
@@ -0,0 +1,126 @@
+#include "profiler.h"
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+
+using namespace EECS;
+
+constexpr size_t Profiler::zonesPerThread;
+constexpr size_t Profiler::framesKept;
+
+namespace {
+void writeEscaped(std::ostream& out, const char* text) {
+    for (; *text; text++) {
+        if (*text == '"' || *text == '\\') {
+            out << '\\';
+        }
+        out << *text;
+    }
+}
+}
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler() : epoch(std::chrono::steady_clock::now()), frameStarts(new std::atomic<int64_t>[framesKept]) {}
+
+void Profiler::record(const char* category, const char* name, int64_t begin, int64_t end) {
+    auto& buffer = threadBuffer();
+    auto index = buffer.written.load(std::memory_order_relaxed);
+    buffer.started.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    auto& zone = buffer.zones[index & (zonesPerThread - 1)];
+    zone.category.store(category, std::memory_order_relaxed);
+    zone.name.store(name, std::memory_order_relaxed);
+    zone.begin.store(begin, std::memory_order_relaxed);
+    zone.end.store(end, std::memory_order_relaxed);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::frame() {
+    auto time = now();
+    auto count = frames.load(std::memory_order_relaxed);
+    if (count > 0) {
+        record("frame", "frame", frameStarts[(count - 1) % framesKept].load(std::memory_order_relaxed), time);
+    }
+
+    frameStarts[count % framesKept].store(time, std::memory_order_relaxed);
+    frames.store(count + 1, std::memory_order_release);
+}
+
+void Profiler::clear() { clearedAt.store(now(), std::memory_order_relaxed); }
+
+void Profiler::writeChromeTrace(std::ostream& out, size_t frameWindow) const {
+    struct Copy {
+        const char* category;
+        const char* name;
+        int64_t begin;
+        int64_t end;
+        uint32_t thread;
+    };
+
+    // zones which began before clear() or ended before the window started are skipped
+    auto cleared = clearedAt.load(std::memory_order_relaxed);
+    auto windowStart = std::numeric_limits<int64_t>::min();
+    auto count = frameCount();
+    frameWindow = std::min(frameWindow, framesKept - 1);
+    if (frameWindow > 0 && count > frameWindow) {
+        windowStart = frameStarts[(count - 1 - frameWindow) % framesKept].load();
+    }
+
+    std::vector<Copy> zones;
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (const auto& buffer : buffers) {
+            auto written = buffer->written.load(std::memory_order_acquire);
+            auto first = written > zonesPerThread ? written - zonesPerThread : 0;
+            auto copied = zones.size();
+            for (auto index = first; index < written; index++) {
+                const auto& zone = buffer->zones[index & (zonesPerThread - 1)];
+                zones.push_back({zone.category.load(std::memory_order_relaxed),
+                                 zone.name.load(std::memory_order_relaxed), zone.begin.load(std::memory_order_relaxed),
+                                 zone.end.load(std::memory_order_relaxed), buffer->thread});
+            }
+
+            // zones which the thread overwrote, or was overwriting, while they were copied are dropped
+            std::atomic_thread_fence(std::memory_order_acquire);
+            auto started = buffer->started.load(std::memory_order_relaxed);
+            auto overwritten = started > zonesPerThread ? started - zonesPerThread : 0;
+            if (overwritten > first) {
+                auto stale = (size_t)std::min(overwritten - first, written - first);
+                zones.erase(zones.begin() + copied, zones.begin() + copied + stale);
+            }
+        }
+    }
+
+    out << "{\"traceEvents\":[";
+    auto separator = "";
+    out << std::fixed << std::setprecision(3);
+    for (const auto& zone : zones) {
+        if (zone.begin < cleared || zone.end <= windowStart) {
+            continue;
+        }
+
+        out << separator << "\n{\"name\":\"";
+        writeEscaped(out, zone.name);
+        out << "\",\"cat\":\"";
+        writeEscaped(out, zone.category);
+        out << "\",\"ph\":\"X\",\"ts\":" << zone.begin / 1000.0 << ",\"dur\":" << (zone.end - zone.begin) / 1000.0
+            << ",\"pid\":0,\"tid\":" << zone.thread << "}";
+        separator = ",";
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+Profiler::ThreadBuffer& Profiler::threadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffers.push_back(std::make_unique<ThreadBuffer>((uint32_t)buffers.size()));
+        buffer = buffers.back().get();
+    }
+
+    return *buffer;
+}
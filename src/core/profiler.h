@@ -0,0 +1,115 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Scoped-zone profiling of engine internals(every Task update, every event type's delivery and every intersection
+// query) is compiled in only when EECS_PROFILER is defined(cmake -DEECS_PROFILER=ON). Otherwise the macros expand to
+// nothing. Lazy queries(view, columns) have no zones of their own, as their cost is in iteration, which counts towards
+// the enclosing zone.
+#ifdef EECS_PROFILER
+#define EECS_PROFILE_CONCAT_(a, b) a##b
+#define EECS_PROFILE_CONCAT(a, b) EECS_PROFILE_CONCAT_(a, b)
+#define EECS_PROFILE_ZONE(category, name) \
+    ::EECS::ProfileScope EECS_PROFILE_CONCAT(profileScope, __LINE__)(category, name)
+#define EECS_PROFILE_FRAME() ::EECS::Profiler::instance().frame()
+#else
+#define EECS_PROFILE_ZONE(category, name) (void)0
+#define EECS_PROFILE_FRAME() (void)0
+#endif
+
+namespace EECS {
+/** \brief records timed zones of code, from any thread, and exports them as Chrome trace
+*
+* Each thread writes zones into its own ring buffer, without locks; when buffer is full, the oldest zones are
+* overwritten. Buffer is registered(under lock) when thread records its first zone. Zones are written when they end,
+* as begin and end timestamps in nanoseconds since profiler was created. Category and name must outlive the profiler,
+* string literals or typeName() results are fine.
+*
+* frame() marks frame boundaries(ECS's main loop calls it), so trace can be limited to the last few frames. Output of
+* writeChromeTrace can be opened in chrome://tracing or Perfetto.
+*/
+class Profiler {
+   public:
+    // zones kept per thread; must be power of 2.
+    static constexpr size_t zonesPerThread = 1 << 16;
+    static constexpr size_t framesKept = 1024;
+
+    static Profiler& instance();
+
+    int64_t now() const { return (std::chrono::steady_clock::now() - epoch).count(); }
+
+    void record(const char* category, const char* name, int64_t begin, int64_t end);
+
+    // ends current frame(recording it as a zone) and begins the next one. Must be called from single thread.
+    void frame();
+    size_t frameCount() const { return frames.load(std::memory_order_acquire); }
+
+    // forgets zones recorded so far. Safe to call while other threads record.
+    void clear();
+
+    /** \brief writes zones as Chrome trace_event JSON
+    *
+    * \param frames number of the last frames to write zones of; 0 writes all zones still kept in buffers.
+    */
+    void writeChromeTrace(std::ostream& out, size_t frames = 0) const;
+
+   private:
+    Profiler();
+
+    struct Zone {
+        std::atomic<const char*> category;
+        std::atomic<const char*> name;
+        std::atomic<int64_t> begin;
+        std::atomic<int64_t> end;
+    };
+
+    // ring written by its thread only, guarded like a seqlock: writer bumps started(and fences) before it overwrites
+    // a slot, and publishes written after; reader copies zones up to written, then drops those whose slots started
+    // being overwritten meanwhile.
+    struct ThreadBuffer {
+        explicit ThreadBuffer(uint32_t thread) : zones(new Zone[zonesPerThread]), thread(thread) {}
+
+        std::unique_ptr<Zone[]> zones;
+        std::atomic<uint64_t> started{0};
+        std::atomic<uint64_t> written{0};
+        uint32_t thread;
+    };
+
+    ThreadBuffer& threadBuffer();
+
+    std::chrono::steady_clock::time_point epoch;
+    std::atomic<int64_t> clearedAt{0};
+
+    std::unique_ptr<std::atomic<int64_t>[]> frameStarts;
+    std::atomic<size_t> frames{0};
+
+    mutable std::mutex buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+/** \brief records zone from its construction to destruction, see Profiler and EECS_PROFILE_ZONE */
+class ProfileScope {
+   public:
+    ProfileScope(const char* category, const char* name)
+        : category(category), name(name), begin(Profiler::instance().now()) {}
+
+    ~ProfileScope() {
+        auto& profiler = Profiler::instance();
+        profiler.record(category, name, begin, profiler.now());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+   private:
+    const char* category;
+    const char* name;
+    int64_t begin;
+};
+}
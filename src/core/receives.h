@@ -1,4 +1,5 @@
 #pragma once
+#include <initializer_list>
 #include <type_traits>
 #include "task.h"
 #include "ecs.h"
@@ -45,4 +46,35 @@ class Receives {
 
     friend Derived;
 };
+
+/** \brief makes Task event driven: it's updated only after events of given types were emitted
+*
+* Like Receives, it must be *after* Task<T> on inheritance list, and gets the task in constructor:
+*
+* class InventorySaver : public Task<InventorySaver>, TriggeredBy<InventoryChanged> {
+*     InventorySaver(ECS& ecs) : Task(ecs), TriggeredBy(this) {}
+*     ...
+* };
+*
+* Task's frequency is ignored then. After emit delivers any of the events - targeted ones too, even if some receiver
+* stopped them(see EventQueue::addTrigger) - TaskScheduler updates the task once, in its next update, with stepTime
+* equal to time since previous update of the task. To get the events themselves, task can also derive from Receives.
+*/
+template <class... Events>
+class TriggeredBy {
+    static_assert(sizeof...(Events) > 0, "TriggeredBy needs at least one event type");
+
+   protected:
+    TriggeredBy(TaskBase* task) : task(task) {
+        task->eventDriven = true;
+        (void)std::initializer_list<int>{(task->ecs.events.addTrigger<Events>(task->triggered), 0)...};
+    }
+
+    ~TriggeredBy() {
+        (void)std::initializer_list<int>{(task->ecs.events.removeTrigger<Events>(task->triggered), 0)...};
+    }
+
+   private:
+    TaskBase* task;
+};
 }
@@ -1,12 +1,191 @@
 #pragma once
 #include <vector>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <deque>
+#include <new>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
 #include "FastDelegate.h"
+#include "../utils/mpscRing.h"
+#include "../utils/span.h"
+#include "../utils/smallFunction.h"
+#include "../utils/openAddressingIndex.h"
+#include "../utils/typeName.h"
+#include "entityID.h"
+#include "sparseEntityTable.h"
+#include "eventLog.h"
+#include "eventStream.h"
+#include "profiler.h"
 
 namespace EECS {
+// true_type if Receiver has receiveBatch(Span<EventType>) method.
+template <class Receiver, class EventType, class = void>
+struct ReceivesBatches : std::false_type {};
+
+template <class Receiver, class EventType>
+struct ReceivesBatches<Receiver, EventType,
+                       decltype((void)std::declval<Receiver&>().receiveBatch(std::declval<Span<EventType>>()))>
+    : std::true_type {};
+
+// Events pushed, but not yet taken for delivery.
+//
+// Elements can be pushed from any thread concurrently. They land in a lock-free ring(allocated on first push); when
+// it's full, in an overflow vector guarded by a mutex. Once anything went to the overflow, all pushes go there until
+// next drain, so elements pushed by the same thread are always drained in order of pushing. Elements pushed by
+// different threads are ordered by the time their pushes reserved place in the ring.
+template <typename T>
+class PushBuffer {
+    using Ring = MPSCRing<T>;
+
+   public:
+    static constexpr size_t ringCapacity = 1024;
+
+    ~PushBuffer() { delete ring.load(); }
+
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        if (!overflowing.load(std::memory_order_acquire) && getRing().tryPush(std::forward<Args>(args)...)) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(overflowMutex);
+        overflow.emplace_back(std::forward<Args>(args)...);
+        overflowing.store(true, std::memory_order_release);
+    }
+
+    // true if nothing was pushed since the last drain, including elements being pushed.
+    bool empty() const {
+        auto existingRing = ring.load(std::memory_order_acquire);
+        return (!existingRing || existingRing->empty()) && !overflowing.load(std::memory_order_acquire);
+    }
+
+    // passes pushed elements to consumer(T&&), in order: first from the ring, then from the overflow. If some push into
+    // the ring is still in progress, overflow is left for the next time, as it holds elements pushed after it.
+    // Only one thread can drain at a time.
+    template <typename Consumer>
+    void drain(Consumer&& consumer) {
+        auto existingRing = ring.load(std::memory_order_acquire);
+        if (existingRing) {
+            existingRing->drain(consumer);
+            if (!existingRing->empty()) {
+                return;
+            }
+        }
+
+        if (!overflowing.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(overflowMutex);
+        for (auto& element : overflow) {
+            consumer(std::move(element));
+        }
+        overflow.clear();
+        overflowing.store(false, std::memory_order_release);
+    }
+
+   private:
+    std::atomic<Ring*> ring{nullptr};
+    std::mutex overflowMutex;
+    std::vector<T> overflow;
+    std::atomic<bool> overflowing{false};
+
+    Ring& getRing() {
+        auto existing = ring.load(std::memory_order_acquire);
+        if (existing) {
+            return *existing;
+        }
+
+        // threads pushing the first element concurrently race to install their ring, losers delete theirs
+        auto created = new Ring(ringCapacity);
+        if (ring.compare_exchange_strong(existing, created, std::memory_order_acq_rel)) {
+            return *created;
+        }
+
+        delete created;
+        return *existing;
+    }
+};
+
+// true_type if EventType has coalesceKey() method, returning integer(like EntityID). Such events form a coalescing
+// channel: of events with equal keys taken for delivery at once, receivers get only one.
+template <class EventType, class = void>
+struct Coalesces : std::false_type {};
+
+template <class EventType>
+struct Coalesces<EventType, decltype((void)std::declval<const EventType&>().coalesceKey())> : std::true_type {};
+
+// true_type if EventType has merge(EventType&&) method, used to coalesce events instead of replacing older with newer.
+template <class EventType, class = void>
+struct MergesEvents : std::false_type {};
+
+template <class EventType>
+struct MergesEvents<EventType, decltype((void)std::declval<EventType&>().merge(std::declval<EventType&&>()))>
+    : std::true_type {};
+
+// true_type if Function can be called with EventType&, so it's connected as a callback rather than receiver object.
+template <class Function, class EventType, class = void>
+struct IsEventCallback : std::false_type {};
+
+template <class Function, class EventType>
+struct IsEventCallback<Function, EventType,
+                       decltype((void)std::declval<Function&>()(std::declval<EventType&>()))> : std::true_type {};
+
+// identifies receiver connected to EventQueue. Default constructed one doesn't identify anything.
+struct Subscription {
+    uint32_t eventID = 0;
+    uint32_t slot = 0;
+    uint32_t generation = 0;
+
+    explicit operator bool() const { return generation != 0; }
+};
+
 class SingleEventQueueBase {
    public:
+    // delivers all pending events to receivers.
     virtual void emit() = 0;
 
+    // moves pending events to the front buffer, from which deliver() will take them. Returns true if there is anything
+    // to deliver.
+    virtual bool swapBuffers() = 0;
+
+    // delivers events from the front buffer to receivers. Events pushed meanwhile wait for the next swapBuffers().
+    virtual void deliver() = 0;
+
+    // true if events were pushed since the last swapBuffers().
+    virtual bool hasPending() const = 0;
+
+    // disconnects receiver identified by subscription. Returns false if it was already disconnected.
+    virtual bool disconnect(const Subscription& subscription) = 0;
+
+    // pushes event kept aside by storeTimed, freeing its slot.
+    virtual void fireTimed(uint32_t slot) = 0;
+
+    // destroys event kept aside by storeTimed, freeing its slot.
+    virtual void dropTimed(uint32_t slot) = 0;
+
+    // pushes event kept aside by storeTimed into the stream instead, freeing its slot.
+    virtual void streamTimed(uint32_t slot, EventStream& stream, uint32_t eventID) = 0;
+
+    // moves event from EventStream record to the front buffer, and destroys the record's one.
+    virtual void takeStreamed(void* event, bool targeted, EntityID target) = 0;
+
+    // destroys event in EventStream record.
+    virtual void dropStreamed(void* event) = 0;
+
+    // writes events in the front buffer to the log, if events of this type can be recorded(are trivially copyable, and
+    // not bigger than EventLogRecord::maxPayloadSize).
+    virtual void record(EventLogWriter& log, uint32_t eventID) = 0;
+
+    // while replaying, pushed events of recordable types are dropped by swapBuffers; replay(record) puts recorded ones
+    // into the front buffer instead. Returns false if the record doesn't fit this event type.
+    virtual void setReplaying(bool replaying) = 0;
+    virtual bool replay(const EventLogRecord& record) = 0;
+
     virtual ~SingleEventQueueBase() {}
 
     virtual std::unique_ptr<SingleEventQueueBase> getNewClassInstance() const = 0;
@@ -14,60 +193,357 @@ class SingleEventQueueBase {
     virtual void clear() = 0;
 };
 
+// Pending events of a single type, and receivers of them.
+//
+// Events can be pushed from any thread concurrently, see PushBuffer. Pushed events form the back buffer. swapBuffers
+// moves them to the front one(events vector), which is then delivered; events pushed by receivers during delivery go to
+// the back buffer, so they're neither lost nor invalidate iteration.
+// emit, connect and disconnect must be called from one thread at a time.
+//
+// Receivers get events in order of priority(receivers of equal priority connected later go first). Receiver gets events
+// either one by one, through receive(EventType&), which can stop propagation of the event by returning false; or, if it
+// has receiveBatch(Span<EventType>), all of them at once, in a single call. Delivery is event by event, unless a batch
+// receiver is connected: then it's receiver by receiver, and batch receiver gets only events which weren't stopped by
+// receivers before it. Callable objects(lambdas, functions) taking EventType& can be connected too, returning bool like
+// receive, or nothing. They're stored in place, in a SmallFunction.
+//
+// Each connected receiver occupies a slot, identified by Subscription, so it can be disconnected in O(1): its entry is
+// only marked dead(tombstone), and dead entries are removed in bulk before delivery, or when they make up half of the
+// list. Connecting appends, and priority order is restored by sorting before the next delivery. Receivers connected
+// during delivery are added after it ends. Receiver objects are connected at most once per list, which costs linear
+// search; callables aren't deduplicated.
+//
+// Events can also be targeted at an entity. These go to a separate lane, delivered after untargeted events of the
+// round, and only to receivers subscribed to that entity - found through an index keyed by EntityID, so delivery costs
+// O(receivers of the entity). Receivers connected to the whole type don't get targeted events.
+//
+// Untargeted events of types with coalesceKey() are coalesced when they're taken for delivery: event whose key is
+// already in the front buffer is merged into the earlier one(by its merge(EventType&&) method, if it has one), or
+// replaces it, keeping its place. Keys present are found through an OpenAddressingIndex, cleared after delivery.
+//
+// Triggers(see EventQueue::addTrigger) are flags set whenever deliver has any events of the type, untargeted or targeted,
+// before any receiver is called - so they're set regardless of receivers stopping propagation.
+//
+// Trivially copyable events can be recorded into an EventLog and replayed from it, see EventQueue::startRecording.
+//
+// Events waiting for their time(see EventQueue::emitAt) are kept aside in slots of a pool, until pushed by fireTimed.
+// Pool is touched only by the thread driving the EventQueue.
 template <typename EventType>
 class SingleEventQueue : public SingleEventQueueBase {
+    using Delegate = fastdelegate::FastDelegate1<EventType&, bool>;
+    using BatchDelegate = fastdelegate::FastDelegate1<Span<EventType>, void>;
+    using Callback = SmallFunction<bool(EventType&)>;
+
+    // exactly one of delegates and callback is set.
     struct DelegateEntry {
-        fastdelegate::FastDelegate1<EventType&, bool> delegate;
+        Delegate delegate;
+        BatchDelegate batchDelegate;
+        Callback callback;
         int priority;
+        uint64_t sequence;  // order of connecting
+        uint32_t slot;
+
+        bool sameReceiver(const DelegateEntry& other) const {
+            return !callback && !other.callback && delegate == other.delegate && batchDelegate == other.batchDelegate;
+        }
+
+        // true if this entry is delivered to before the other one.
+        bool precedes(const DelegateEntry& other) const {
+            return priority < other.priority || (priority == other.priority && sequence > other.sequence);
+        }
+    };
+
+    struct ReceiverList {
+        std::vector<DelegateEntry> entries;
+        size_t tombstones = 0;  // entries of disconnected receivers, not removed yet
+        bool unsorted = false;
+    };
+
+    // state of the subscription, indexed by Subscription::slot.
+    struct SubscriptionSlot {
+        uint32_t generation = 1;
+        bool connected = false;
+        bool pending = false;   // connected during delivery, not in any list yet
+        bool targeted = false;  // in list of the entity's subscribers, rather than receivers of all events
+        EntityID entity = 0;
     };
 
+    struct TargetedEvent {
+        template <typename... Args>
+        TargetedEvent(EntityID target, Args&&... args) : target(target), event(std::forward<Args>(args)...) {}
+
+        EntityID target;
+        EventType event;
+    };
+
+    // receivers subscribed to events targeted at the entity.
+    struct Subscribers {
+        EntityID entity;
+        ReceiverList receivers;
+    };
+
+    struct CallbackTag {};
+    struct BatchTag {};
+    struct ObjectTag {};
+
+    template <typename Receiver>
+    using ReceiverKind = std::conditional_t<IsEventCallback<Receiver, EventType>::value, CallbackTag,
+                                            std::conditional_t<ReceivesBatches<Receiver, EventType>::value, BatchTag,
+                                                               ObjectTag>>;
+
    public:
+    // constructs event in a free slot of the timed events pool, returns index of the slot.
+    template <typename... Args>
+    uint32_t storeTimed(Args&&... args) {
+        uint32_t slot;
+        if (!freeTimedSlots.empty()) {
+            slot = freeTimedSlots.back();
+            freeTimedSlots.pop_back();
+        } else {
+            slot = (uint32_t)timedEvents.size();
+            timedEvents.emplace_back();
+        }
+
+        new (&timedEvents[slot]) EventType(std::forward<Args>(args)...);
+        return slot;
+    }
+
+    void fireTimed(uint32_t slot) override {
+        auto event = (EventType*)&timedEvents[slot];
+        emplace(std::move(*event));
+        dropTimed(slot);
+    }
+
+    void dropTimed(uint32_t slot) override {
+        ((EventType*)&timedEvents[slot])->~EventType();
+        freeTimedSlots.push_back(slot);
+    }
+
+    void streamTimed(uint32_t slot, EventStream& stream, uint32_t eventID) override {
+        auto event = (EventType*)&timedEvents[slot];
+        stream.push<EventType>(eventID, false, 0, std::move(*event));
+        dropTimed(slot);
+    }
+
+    void takeStreamed(void* event, bool targeted, EntityID target) override {
+        auto streamed = (EventType*)event;
+        if (!(replaying && recordable)) {
+            if (targeted) {
+                targetedEvents.emplace_back(target, std::move(*streamed));
+            } else {
+                append(std::move(*streamed));
+            }
+        }
+        streamed->~EventType();
+    }
+
+    void dropStreamed(void* event) override { ((EventType*)event)->~EventType(); }
+
     void emit() override {
-        for (auto& event : events) {
-            for (auto& delegate : delegates) {
-                if (!delegate.delegate(event)) {
+        swapBuffers();
+        deliver();
+    }
+
+    bool swapBuffers() override {
+        if (replaying && recordable) {
+            pushed.drain([](EventType&&) {});
+            pushedTargeted.drain([](TargetedEvent&&) {});
+            return false;
+        }
+
+        pushed.drain([this](EventType&& event) { append(std::move(event)); });
+        pushedTargeted.drain([this](TargetedEvent&& event) { targetedEvents.push_back(std::move(event)); });
+        return !events.empty() || !targetedEvents.empty();
+    }
+
+    bool hasPending() const override { return !pushed.empty() || !pushedTargeted.empty(); }
+
+    void record(EventLogWriter& log, uint32_t eventID) override {
+        if (!recordable) {
+            return;
+        }
+
+        for (const auto& event : events) {
+            log.event(eventID, &event, sizeof(EventType));
+        }
+
+        for (const auto& targeted : targetedEvents) {
+            log.targetedEvent(eventID, targeted.target, &targeted.event, sizeof(EventType));
+        }
+    }
+
+    void setReplaying(bool replaying) override { this->replaying = replaying; }
+
+    bool replay(const EventLogRecord& record) override {
+        if (!recordable || record.payload.size() != sizeof(EventType)) {
+            return false;
+        }
+
+        typename std::aligned_storage<sizeof(EventType), alignof(EventType)>::type event;
+        std::memcpy(&event, record.payload.data(), sizeof(EventType));
+        if (record.type == EventLogRecord::Type::TargetedEvent) {
+            targetedEvents.emplace_back(record.target, *(EventType*)&event);
+        } else {
+            events.push_back(*(EventType*)&event);
+        }
+
+        return true;
+    }
+
+    void deliver() override {
+        EECS_PROFILE_ZONE("event", typeName<EventType>());
+        if (!events.empty() || !targetedEvents.empty()) {
+            for (auto trigger : triggers) {
+                *trigger = true;
+            }
+        }
+
+        prepare(receivers);
+        delivering = true;
+
+        auto batched = [this](const DelegateEntry& entry) {
+            return entry.batchDelegate && slots[entry.slot].connected;
+        };
+        if (std::any_of(receivers.entries.begin(), receivers.entries.end(), batched)) {
+            deliverToEachReceiver();
+        } else {
+            deliverEachEvent();
+        }
+        events.clear();
+        coalescingIndex.clear();
+
+        for (auto& targeted : targetedEvents) {
+            auto entitySubscribers = findSubscribers(targeted.target);
+            if (!entitySubscribers || !prepare(*entitySubscribers)) {
+                continue;
+            }
+
+            for (auto& entry : entitySubscribers->receivers.entries) {
+                if (slots[entry.slot].connected && !invoke(entry, targeted.event)) {
                     break;
                 }
             }
         }
-        events.clear();
+        targetedEvents.clear();
+
+        delivering = false;
+        for (auto& entry : pendingEntries) {
+            slots[entry.slot].pending = false;
+            if (slots[entry.slot].connected) {
+                insert(std::move(entry));
+            } else {
+                releaseSlot(entry.slot);
+            }
+        }
+        pendingEntries.clear();
     }
 
-    void push(EventType&& event) { events.push_back(std::move(event)); }
+    void push(EventType&& event) { emplace(std::move(event)); }
 
     template <typename... Args>
     void emplace(Args&&... args) {
-        events.emplace_back(std::forward<Args>(args)...);
+        pushed.emplace(std::forward<Args>(args)...);
     }
 
-    template <typename ObjectType>
-    void connect(ObjectType& obj, int priority) {
-        auto alreadyConnected = std::find_if(delegates.begin(), delegates.end(), [&obj](DelegateEntry& delegateEntry) {
-            return delegateEntry.delegate == fastdelegate::FastDelegate1<EventType&, bool>{&obj, &ObjectType::receive};
-        });
-        if (alreadyConnected != delegates.end()) {
-            return;
+    // constructs event targeted at given entity.
+    template <typename... Args>
+    void emplaceTo(EntityID target, Args&&... args) {
+        pushedTargeted.emplace(target, std::forward<Args>(args)...);
+    }
+
+    // sets the flag whenever events of this type are delivered, until removeTrigger.
+    void addTrigger(bool& flag) { triggers.push_back(&flag); }
+
+    void removeTrigger(bool& flag) {
+        auto found = std::find(triggers.begin(), triggers.end(), &flag);
+        if (found != triggers.end()) {
+            triggers.erase(found);
         }
+    }
+
+    // connects receiver object or callable to all untargeted events.
+    template <typename Receiver>
+    Subscription connect(Receiver&& receiver, int priority) {
+        return connectEntry(makeEntry(std::forward<Receiver>(receiver), priority), false, 0);
+    }
 
-        auto place = std::lower_bound(delegates.begin(), delegates.end(), priority,
-                                      [](const auto& delegate, int priority) { return delegate.priority < priority; });
-        delegates.insert(place, {fastdelegate::FastDelegate1<EventType&, bool>{&obj, &ObjectType::receive}, priority});
+    // connects receiver object or callable to events targeted at given entity.
+    template <typename Receiver>
+    Subscription connect(EntityID entity, Receiver&& receiver, int priority) {
+        return connectEntry(makeEntry(std::forward<Receiver>(receiver), priority), true, entity);
+    }
+
+    bool disconnect(const Subscription& subscription) override {
+        if (subscription.slot >= slots.size() || slots[subscription.slot].generation != subscription.generation ||
+            !slots[subscription.slot].connected) {
+            return false;
+        }
+
+        tombstone(subscription.slot);
+        return true;
     }
 
     template <typename ObjectType>
     void disconnect(ObjectType& obj) {
-        auto delegateIt = std::find_if(delegates.begin(), delegates.end(), [&obj](DelegateEntry& delegateEntry) {
-            return delegateEntry.delegate == fastdelegate::FastDelegate1<EventType&, bool>{&obj, &ObjectType::receive};
-        });
+        auto entry = findEntry(makeEntry(obj, 0), false, 0);
+        if (entry) {
+            tombstone(entry->slot);
+        }
+    }
 
-        if (delegateIt != delegates.end()) {
-            delegates.erase(delegateIt);
+    template <typename ObjectType>
+    void disconnect(EntityID entity, ObjectType& obj) {
+        auto entry = findEntry(makeEntry(obj, 0), true, entity);
+        if (entry) {
+            tombstone(entry->slot);
+        }
+    }
+
+    // removes all subscriptions to events targeted at given entity.
+    void disconnectAll(EntityID entity) {
+        for (auto& entry : pendingEntries) {
+            if (slots[entry.slot].targeted && slots[entry.slot].entity == entity) {
+                slots[entry.slot].connected = false;
+            }
+        }
+
+        auto entitySubscribers = findSubscribers(entity);
+        if (!entitySubscribers) {
+            return;
+        }
+
+        for (auto& entry : entitySubscribers->receivers.entries) {
+            if (slots[entry.slot].connected) {
+                slots[entry.slot].connected = false;
+                entitySubscribers->receivers.tombstones++;
+            }
+        }
+
+        if (!delivering) {
+            prepare(*entitySubscribers);
         }
     }
 
     void clear() override {
+        pushed.drain([](EventType&&) {});
+        pushedTargeted.drain([](TargetedEvent&&) {});
         events.clear();
-        delegates.clear();
+        coalescingIndex.clear();
+        targetedEvents.clear();
+        triggers.clear();
+
+        // slots are released rather than dropped, so outstanding Subscriptions stay invalid
+        releaseAll(receivers);
+        for (auto& entitySubscribers : subscribers) {
+            releaseAll(entitySubscribers.receivers);
+        }
+        for (auto& entry : pendingEntries) {
+            releaseSlot(entry.slot);
+        }
+        receivers = {};
+        pendingEntries.clear();
+        subscribers.clear();
+        subscriberIndex.clear();
     }
 
     // returns new object of the same class as *this*.
@@ -76,7 +552,342 @@ class SingleEventQueue : public SingleEventQueueBase {
     }
 
    private:
-    std::vector<DelegateEntry> delegates;
-    std::vector<EventType> events;
+    static constexpr bool recordable =
+        std::is_trivially_copyable<EventType>::value && sizeof(EventType) <= EventLogRecord::maxPayloadSize;
+
+    ReceiverList receivers;                     // receivers of untargeted events
+    std::vector<DelegateEntry> pendingEntries;  // connected during delivery
+    std::vector<SubscriptionSlot> slots;
+    std::vector<uint32_t> freeSlots;
+    uint64_t nextSequence = 0;
+    bool delivering = false;
+
+    std::vector<EventType> events;  // front buffer, events being delivered
+    std::vector<bool> stopped;      // events stopped by the receiver being called
+
+    // coalesceKey -> position in events, used by coalescing types
+    OpenAddressingIndex coalescingIndex;
+
+    PushBuffer<EventType> pushed;
+
+    std::vector<TargetedEvent> targetedEvents;  // front buffer of targeted events
+    PushBuffer<TargetedEvent> pushedTargeted;
+    SparseEntityTable subscriberIndex;  // entity -> position in subscribers
+    std::vector<Subscribers> subscribers;
+
+    bool replaying = false;
+
+    std::vector<bool*> triggers;
+
+    // deque, so growing it doesn't move events already stored
+    std::deque<typename std::aligned_storage<sizeof(EventType), alignof(EventType)>::type> timedEvents;
+    std::vector<uint32_t> freeTimedSlots;
+
+    template <typename Receiver>
+    static DelegateEntry makeEntry(Receiver&& receiver, int priority) {
+        DelegateEntry entry;
+        entry.priority = priority;
+        setReceiver(entry, std::forward<Receiver>(receiver), ReceiverKind<std::decay_t<Receiver>>());
+        return entry;
+    }
+
+    template <typename ObjectType>
+    static void setReceiver(DelegateEntry& entry, ObjectType& obj, ObjectTag) {
+        entry.delegate = Delegate{&obj, &ObjectType::receive};
+    }
+
+    template <typename ObjectType>
+    static void setReceiver(DelegateEntry& entry, ObjectType& obj, BatchTag) {
+        entry.batchDelegate = BatchDelegate{&obj, &ObjectType::receiveBatch};
+    }
+
+    template <typename Function>
+    static void setReceiver(DelegateEntry& entry, Function&& function, CallbackTag) {
+        using Result = decltype(std::declval<std::decay_t<Function>&>()(std::declval<EventType&>()));
+        setCallback(entry, std::forward<Function>(function), std::is_same<Result, bool>());
+    }
+
+    template <typename Function>
+    static void setCallback(DelegateEntry& entry, Function&& function, std::true_type) {
+        entry.callback = Callback(std::forward<Function>(function));
+    }
+
+    // callables returning nothing never stop propagation.
+    template <typename Function>
+    static void setCallback(DelegateEntry& entry, Function&& function, std::false_type) {
+        entry.callback = Callback([function = std::forward<Function>(function)](EventType& event) mutable {
+            function(event);
+            return true;
+        });
+    }
+
+    // puts event into the front buffer, coalescing it if its type does so.
+    void append(EventType&& event) { append(std::move(event), Coalesces<EventType>()); }
+
+    void append(EventType&& event, std::false_type) { events.push_back(std::move(event)); }
+
+    void append(EventType&& event, std::true_type) {
+        auto position = coalescingIndex.findOrInsert((uint64_t)event.coalesceKey(), (uint32_t)events.size());
+        if (position.second) {
+            events.push_back(std::move(event));
+        } else {
+            coalesce(events[position.first], std::move(event), MergesEvents<EventType>());
+        }
+    }
+
+    static void coalesce(EventType& older, EventType&& newer, std::true_type) { older.merge(std::move(newer)); }
+    static void coalesce(EventType& older, EventType&& newer, std::false_type) { older = std::move(newer); }
+
+    // delivers events one by one, each to all receivers, unless one of them stops it.
+    void deliverEachEvent() {
+        for (auto& event : events) {
+            for (auto& entry : receivers.entries) {
+                if (slots[entry.slot].connected && !invoke(entry, event)) {
+                    break;
+                }
+            }
+        }
+    }
+
+    // delivers events receiver by receiver, so batch receivers get all events which weren't stopped before them.
+    void deliverToEachReceiver() {
+        // events [0, live) weren't stopped yet
+        auto live = events.size();
+        for (auto& entry : receivers.entries) {
+            if (live == 0) {
+                break;
+            }
+
+            if (!slots[entry.slot].connected) {
+                continue;
+            }
+
+            if (entry.batchDelegate) {
+                entry.batchDelegate(Span<EventType>(events.data(), live));
+                continue;
+            }
+
+            stopped.assign(live, false);
+            auto anyStopped = false;
+            for (auto i = 0u; i < live && slots[entry.slot].connected; i++) {
+                if (!invoke(entry, events[i])) {
+                    stopped[i] = true;
+                    anyStopped = true;
+                }
+            }
+
+            if (anyStopped) {
+                live = compact(live);
+            }
+        }
+    }
+
+    // passes single event to the receiver. Returns false if it stopped propagation of the event.
+    static bool invoke(DelegateEntry& entry, EventType& event) {
+        if (entry.batchDelegate) {
+            entry.batchDelegate(Span<EventType>(&event, 1));
+            return true;
+        }
+
+        return entry.callback ? entry.callback(event) : entry.delegate(event);
+    }
+
+    Subscription connectEntry(DelegateEntry entry, bool targeted, EntityID entity) {
+        auto existing = entry.callback ? nullptr : findEntry(entry, targeted, entity);
+        if (existing) {
+            return {0, existing->slot, slots[existing->slot].generation};
+        }
+
+        entry.slot = allocateSlot(targeted, entity);
+        entry.sequence = nextSequence++;
+        Subscription subscription{0, entry.slot, slots[entry.slot].generation};
+
+        if (delivering) {
+            slots[entry.slot].pending = true;
+            pendingEntries.push_back(std::move(entry));
+        } else {
+            insert(std::move(entry));
+        }
+
+        return subscription;
+    }
+
+    // connected entry of the same receiver object in given list, or nullptr.
+    DelegateEntry* findEntry(const DelegateEntry& entry, bool targeted, EntityID entity) {
+        auto matches = [&](const DelegateEntry& other) {
+            const auto& slot = slots[other.slot];
+            return slot.connected && slot.targeted == targeted && slot.entity == entity && other.sameReceiver(entry);
+        };
+
+        auto list = targeted ? listOf(entity) : &receivers;
+        if (list) {
+            auto found = std::find_if(list->entries.begin(), list->entries.end(), matches);
+            if (found != list->entries.end()) {
+                return &*found;
+            }
+        }
+
+        auto found = std::find_if(pendingEntries.begin(), pendingEntries.end(), matches);
+        return found != pendingEntries.end() ? &*found : nullptr;
+    }
+
+    // appends entry to its list, marking the list unsorted if it breaks the order.
+    void insert(DelegateEntry&& entry) {
+        const auto& slot = slots[entry.slot];
+        auto& list = slot.targeted ? subscribersOf(slot.entity).receivers : receivers;
+        if (!list.entries.empty() && !list.entries.back().precedes(entry)) {
+            list.unsorted = true;
+        }
+        list.entries.push_back(std::move(entry));
+    }
+
+    uint32_t allocateSlot(bool targeted, EntityID entity) {
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            slot = (uint32_t)slots.size();
+            slots.emplace_back();
+        }
+
+        slots[slot].connected = true;
+        slots[slot].targeted = targeted;
+        slots[slot].entity = entity;
+        return slot;
+    }
+
+    // makes slot reusable; Subscriptions of it are invalidated by bumping its generation.
+    void releaseSlot(uint32_t slot) {
+        slots[slot].connected = false;
+        if (++slots[slot].generation != 0) {
+            freeSlots.push_back(slot);
+        }
+    }
+
+    void releaseAll(ReceiverList& list) {
+        for (auto& entry : list.entries) {
+            releaseSlot(entry.slot);
+        }
+        list = {};
+    }
+
+    void tombstone(uint32_t slot) {
+        auto& state = slots[slot];
+        state.connected = false;
+        if (state.pending) {
+            return;
+        }
+
+        if (!state.targeted) {
+            receivers.tombstones++;
+            if (!delivering && receivers.tombstones * 2 > receivers.entries.size()) {
+                prepare(receivers);
+            }
+            return;
+        }
+
+        auto entitySubscribers = findSubscribers(state.entity);
+        if (!entitySubscribers) {
+            return;
+        }
+
+        auto& list = entitySubscribers->receivers;
+        list.tombstones++;
+        if (!delivering && list.tombstones * 2 > list.entries.size()) {
+            prepare(*entitySubscribers);
+        }
+    }
+
+    // removes dead entries and restores priority order of the list.
+    void prepare(ReceiverList& list) {
+        if (list.tombstones > 0) {
+            auto connected = [this](const DelegateEntry& entry) { return slots[entry.slot].connected; };
+            auto dead = std::stable_partition(list.entries.begin(), list.entries.end(), connected);
+            for (auto entry = dead; entry != list.entries.end(); entry++) {
+                releaseSlot(entry->slot);
+            }
+            list.entries.erase(dead, list.entries.end());
+            list.tombstones = 0;
+        }
+
+        if (list.unsorted) {
+            std::sort(list.entries.begin(), list.entries.end(),
+                      [](const DelegateEntry& a, const DelegateEntry& b) { return a.precedes(b); });
+            list.unsorted = false;
+        }
+    }
+
+    // prepares list of entity's subscribers, erasing it if it's empty. Returns false if it was erased.
+    bool prepare(Subscribers& entitySubscribers) {
+        prepare(entitySubscribers.receivers);
+        if (entitySubscribers.receivers.entries.empty()) {
+            eraseSubscribers(entitySubscribers.entity);
+            return false;
+        }
+
+        return true;
+    }
+
+    ReceiverList* listOf(EntityID entity) {
+        auto entitySubscribers = findSubscribers(entity);
+        return entitySubscribers ? &entitySubscribers->receivers : nullptr;
+    }
+
+    Subscribers* findSubscribers(EntityID entity) {
+        auto index = subscriberIndex.find(entity);
+        if (index == SparseEntityTable::noIndex || subscribers[index].entity != entity) {
+            return nullptr;
+        }
+
+        return &subscribers[index];
+    }
+
+    Subscribers& subscribersOf(EntityID entity) {
+        auto& index = subscriberIndex.slot(entity);
+        if (index == SparseEntityTable::noIndex) {
+            index = (SparseEntityTable::Index)subscribers.size();
+            subscribers.push_back({entity, {}});
+        } else if (subscribers[index].entity != entity) {
+            // subscriptions left by the entity which previously occupied this index are dead
+            releaseAll(subscribers[index].receivers);
+            subscribers[index].entity = entity;
+        }
+
+        return subscribers[index];
+    }
+
+    // removes entity's entry, moving the last one into its place.
+    void eraseSubscribers(EntityID entity) {
+        auto& index = subscriberIndex.slot(entity);
+        if (index != subscribers.size() - 1) {
+            subscriberIndex.slot(subscribers.back().entity) = index;
+            subscribers[index] = std::move(subscribers.back());
+        }
+
+        subscribers.pop_back();
+        index = SparseEntityTable::noIndex;
+    }
+
+    // moves events which weren't stopped to the front, keeping their order. Returns their number.
+    size_t compact(size_t live) {
+        size_t kept = 0;
+        for (auto i = 0u; i < live; i++) {
+            if (!stopped[i]) {
+                if (kept != i) {
+                    events[kept] = std::move(events[i]);
+                }
+                kept++;
+            }
+        }
+
+        return kept;
+    }
 };
+
+template <typename T>
+constexpr size_t PushBuffer<T>::ringCapacity;
+
+template <typename EventType>
+constexpr bool SingleEventQueue<EventType>::recordable;
 }
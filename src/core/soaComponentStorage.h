@@ -0,0 +1,269 @@
+#pragma once
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <cstddef>
+#include <cassert>
+#include "componentStorage.h"
+#include "sparseEntityTable.h"
+#include "entityID.h"
+#include "../utils/span.h"
+#include "../utils/alignedAllocator.h"
+
+namespace EECS {
+// Describes a single data member of a component stored with SoAStorage. Use EECS_FIELD macro to declare it.
+template <class MemberPointer, MemberPointer member>
+struct Field;
+
+template <class T, class M, M T::*member>
+struct Field<M T::*, member> {
+    using Type = M;
+
+    static M& of(T& component) { return component.*member; }
+
+    static bool refersTo(M T::*other) { return other == member; }
+
+    template <class OtherMemberPointer>
+    static bool refersTo(OtherMemberPointer) {
+        return false;
+    }
+};
+
+#define EECS_FIELD(member) ::EECS::Field<decltype(member), member>
+
+// List of fields of a component stored with SoAStorage, for ex.
+// using Fields = FieldList<EECS_FIELD(&PositionComponent::x), EECS_FIELD(&PositionComponent::y)>;
+template <class... Fields>
+struct FieldList {};
+
+template <class T>
+class SoAComponentRef;
+
+template <class T, class FieldList>
+class SoAColumns;
+
+/** \brief columns of all components of type T stored with SoAStorage
+*
+* Row i of every column belongs to entity entities()[i]. Columns are aligned to columnAlignment bytes, so kernels over
+* them can be auto-vectorized, or written with aligned SIMD loads. Rows are kept dense: deletion moves the last row into
+* the freed one, so rows aren't ordered by entityID.
+*
+* Span<float> xs = comps.columns<PositionComponent>().column(&PositionComponent::x);
+*
+* Adding or deleting components of type T invalidates obtained spans.
+*/
+template <class T, class... Fields>
+class SoAColumns<T, FieldList<Fields...>> {
+    static_assert(sizeof...(Fields) > 0, "Component stored with SoAStorage must declare at least one field");
+
+    using Index = SparseEntityTable::Index;
+    static constexpr Index noRow = SparseEntityTable::noIndex;
+
+   public:
+    static constexpr size_t columnAlignment = 64;
+
+    template <class U>
+    using Column = std::vector<U, AlignedAllocator<U, columnAlignment>>;
+
+    // type of index-th field from the list.
+    template <size_t index>
+    using FieldType = typename std::tuple_element<index, std::tuple<typename Fields::Type...>>::type;
+
+    size_t size() const { return entityColumn.size(); }
+
+    Span<const EntityID> entities() const { return Span<const EntityID>(entityColumn.data(), entityColumn.size()); }
+
+    template <size_t index>
+    Span<FieldType<index>> column() {
+        auto& column = std::get<index>(columns);
+        return Span<FieldType<index>>(column.data(), column.size());
+    }
+
+    // returns column of the field given by member pointer, or empty span if it isn't on the field list.
+    template <class M>
+    Span<M> column(M T::*member) {
+        static_assert(isFieldType<M>(), "Member isn't of type of any field listed in T::Fields");
+        return columnOf(member, std::index_sequence_for<Fields...>());
+    }
+
+    // returns row of given entity's component, or size() if it doesn't exist.
+    size_t row(EntityID entityID) const {
+        auto row = rows.find(entityID);
+        return row == noRow || entityColumn[row] != entityID ? size() : row;
+    }
+
+    bool has(EntityID entityID) const { return row(entityID) != size(); }
+
+    // gathers fields of the entity's component into T. Component must exist.
+    T load(EntityID entityID) const {
+        T component;
+        component.entityID = entityID;
+        load(component, row(entityID), std::index_sequence_for<Fields...>());
+        return component;
+    }
+
+    // scatters fields of given component into the entity's row. Component must exist.
+    void store(EntityID entityID, T component) {
+        store(std::move(component), row(entityID), std::index_sequence_for<Fields...>());
+    }
+
+    SoAComponentRef<T> get(EntityID entityID) {
+        return has(entityID) ? SoAComponentRef<T>(*this, entityID) : SoAComponentRef<T>();
+    }
+
+    template <typename... Args>
+    SoAComponentRef<T> add(EntityID entityID, Args&&... args) {
+        T component(std::forward<Args>(args)...);
+
+        // row of the entity which previously occupied the same index is just taken over.
+        auto& row = rows.slot(entityID);
+        if (row == noRow) {
+            row = (Index)size();
+            entityColumn.push_back(entityID);
+            append(std::move(component), std::index_sequence_for<Fields...>());
+        } else {
+            entityColumn[row] = entityID;
+            store(std::move(component), row, std::index_sequence_for<Fields...>());
+        }
+
+        return SoAComponentRef<T>(*this, entityID);
+    }
+
+    bool remove(EntityID entityID) {
+        auto removed = row(entityID);
+        if (removed == size()) {
+            return false;
+        }
+
+        auto last = size() - 1;
+        if (removed != last) {
+            entityColumn[removed] = entityColumn[last];
+            rows.slot(entityColumn[removed]) = (Index)removed;
+        }
+        entityColumn.pop_back();
+        fillHole(removed, std::index_sequence_for<Fields...>());
+        rows.slot(entityID) = noRow;
+
+        return true;
+    }
+
+    void clear() {
+        entityColumn.clear();
+        columns = std::tuple<Column<typename Fields::Type>...>();
+        rows.clear();
+    }
+
+   private:
+    using expand = int[];
+
+    template <class M>
+    static constexpr bool isFieldType() {
+        bool matches[] = {std::is_same<M, typename Fields::Type>::value...};
+        for (auto match : matches) {
+            if (match) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Column<EntityID> entityColumn;
+    std::tuple<Column<typename Fields::Type>...> columns;
+    SparseEntityTable rows;
+
+    template <class M, size_t... indices>
+    Span<M> columnOf(M T::*member, std::index_sequence<indices...>) {
+        void* data = nullptr;
+        (void)expand{0, (data = !data && Fields::refersTo(member) ? (void*)std::get<indices>(columns).data() : data,
+                         0)...};
+        return Span<M>((M*)data, data ? size() : 0);
+    }
+
+    template <size_t... indices>
+    void load(T& component, size_t row, std::index_sequence<indices...>) const {
+        (void)expand{0, (Fields::of(component) = std::get<indices>(columns)[row], 0)...};
+    }
+
+    template <size_t... indices>
+    void store(T&& component, size_t row, std::index_sequence<indices...>) {
+        (void)expand{0, (std::get<indices>(columns)[row] = std::move(Fields::of(component)), 0)...};
+    }
+
+    template <size_t... indices>
+    void append(T&& component, std::index_sequence<indices...>) {
+        (void)expand{0, (std::get<indices>(columns).push_back(std::move(Fields::of(component))), 0)...};
+    }
+
+    // moves the last row of each field column into given one and drops the last row.
+    template <size_t... indices>
+    void fillHole(size_t row, std::index_sequence<indices...>) {
+        (void)expand{0, (std::get<indices>(columns)[row] = std::move(std::get<indices>(columns).back()),
+                         std::get<indices>(columns).pop_back(), 0)...};
+    }
+};
+
+template <class T, class... Fields>
+constexpr typename SoAColumns<T, FieldList<Fields...>>::Index SoAColumns<T, FieldList<Fields...>>::noRow;
+
+template <class T, class... Fields>
+constexpr size_t SoAColumns<T, FieldList<Fields...>>::columnAlignment;
+
+// Stores every field listed in T::Fields in its own column, see SoAColumns.
+template <class T>
+class ComponentStorage<T, SoAStorage> : public SoAColumns<T, typename T::Fields>,
+                                        public LoopedBulkOperations<ComponentStorage<T, SoAStorage>> {
+   public:
+    static constexpr bool sorted = false;
+};
+
+template <class T>
+constexpr bool ComponentStorage<T, SoAStorage>::sorted;
+
+/** \brief reference to a component stored with SoAStorage
+*
+* There is no T object in such storage, so this is returned instead of T*. It doesn't hold position of the component,
+* but finds it on each access(in O(1)), so unlike pointers it stays valid when components are added or deleted.
+*
+* auto position = comps.getComponent<PositionComponent>(entity);
+* if (position) {
+*     position.get(&PositionComponent::x) += 5;
+* }
+*/
+template <class T>
+class SoAComponentRef {
+   public:
+    SoAComponentRef(std::nullptr_t = nullptr) {}
+    SoAComponentRef(SoAColumns<T, typename T::Fields>& columns, EntityID entityID)
+        : columns(&columns), entityID(entityID) {}
+
+    explicit operator bool() const { return columns && columns->has(entityID); }
+    bool operator==(std::nullptr_t) const { return !*this; }
+    bool operator!=(std::nullptr_t) const { return (bool)*this; }
+
+    EntityID entity() const { return entityID; }
+
+    // returns reference to given field. Component must exist, and member must be listed in T::Fields. Members of type
+    // of no listed field are rejected at compile time; member pointer itself isn't a constant expression here, so
+    // other unlisted members are only caught by assert.
+    template <class M>
+    M& get(M T::*member) const {
+        auto column = columns->column(member);
+        assert(column.data() && "member passed to SoAComponentRef::get isn't listed in T::Fields!");
+        return column[columns->row(entityID)];
+    }
+
+    template <size_t index>
+    auto& field() const {
+        return columns->template column<index>()[columns->row(entityID)];
+    }
+
+    // returns copy of the component, with all fields gathered from the columns.
+    T load() const { return columns->load(entityID); }
+
+    void store(T component) const { columns->store(entityID, std::move(component)); }
+
+   private:
+    SoAColumns<T, typename T::Fields>* columns = nullptr;
+    EntityID entityID = 0;
+};
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "componentStorage.h"
+#include "entityID.h"
+#include "../utils/span.h"
+
+namespace EECS {
+// Stores components in a vector sorted by entityID.
+template <class T>
+class ComponentStorage<T, SortedStorage> {
+   public:
+    // true if components returned by all() are ordered by entityID.
+    static constexpr bool sorted = true;
+
+    T* get(EntityID entityID) {
+        auto componentIt = find(entityID);
+        if (componentIt == components.end() || componentIt->entityID != entityID) {
+            return nullptr;
+        }
+
+        return &*componentIt;
+    }
+
+    template <typename... Args>
+    T* add(EntityID entityID, Args&&... args) {
+        auto place = find(entityID);
+
+        auto componentAlreadyExists = place != components.end() && place->entityID == entityID;
+        if (componentAlreadyExists) {
+            *place = T(std::forward<Args>(args)...);
+        } else {
+            place = components.insert(place, T(std::forward<Args>(args)...));
+        }
+
+        place->entityID = entityID;
+        return &*place;
+    }
+
+    bool remove(EntityID entityID) {
+        auto componentIt = find(entityID);
+        if (componentIt != components.end() && componentIt->entityID == entityID) {
+            components.erase(componentIt);
+            return true;
+        }
+
+        return false;
+    }
+
+    // Appends new components, sorts them and merges them with the old ones in one pass, so it's O((n + k) lg k), not
+    // O(n * k) like k additions. factory(i) returns component for entityIDs[i]; it's called in entityID order.
+    // If entity is given more than once, the last one wins.
+    template <class Factory>
+    void addBulk(Span<const EntityID> entityIDs, Factory&& factory) {
+        std::vector<size_t> order(entityIDs.size());
+        for (auto i = 0u; i < order.size(); i++) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [&](size_t first, size_t second) { return entityIDs[first] < entityIDs[second]; });
+
+        auto oldSize = components.size();
+        components.reserve(oldSize + order.size());
+
+        size_t existing = 0;  // old components before this one have lower entityIDs than the current one
+        for (auto i = 0u; i < order.size(); i++) {
+            auto entityID = entityIDs[order[i]];
+            if (i + 1 < order.size() && entityIDs[order[i + 1]] == entityID) {
+                continue;
+            }
+
+            auto oldEnd = components.begin() + oldSize;
+            existing = std::lower_bound(components.begin() + existing, oldEnd, entityID, byEntity) - components.begin();
+            if (existing < oldSize && components[existing].entityID == entityID) {
+                components[existing] = factory(order[i]);
+                components[existing].entityID = entityID;
+            } else {
+                components.push_back(factory(order[i]));
+                components.back().entityID = entityID;
+            }
+        }
+
+        std::inplace_merge(components.begin(), components.begin() + oldSize, components.end(),
+                           [](const T& first, const T& second) { return first.entityID < second.entityID; });
+    }
+
+    // deletes components of all given entities in a single compaction pass. Returns number of deleted components.
+    size_t removeBulk(Span<const EntityID> entityIDs) {
+        std::vector<EntityID> deleted(entityIDs.begin(), entityIDs.end());
+        std::sort(deleted.begin(), deleted.end());
+
+        auto nextDeleted = deleted.begin();
+        auto kept = components.begin();
+        for (auto component = components.begin(); component != components.end(); ++component) {
+            nextDeleted = std::lower_bound(nextDeleted, deleted.end(), component->entityID);
+            if (nextDeleted != deleted.end() && *nextDeleted == component->entityID) {
+                continue;
+            }
+
+            if (kept != component) {
+                *kept = std::move(*component);
+            }
+            ++kept;
+        }
+
+        auto deletedCount = (size_t)(components.end() - kept);
+        components.erase(kept, components.end());
+        return deletedCount;
+    }
+
+    void clear() { components.clear(); }
+
+    std::vector<T>& all() { return components; }
+
+   private:
+    std::vector<T> components;
+
+    static bool byEntity(const T& component, EntityID entityID) { return component.entityID < entityID; }
+
+    typename std::vector<T>::iterator find(EntityID entityID) {
+        return std::lower_bound(components.begin(), components.end(), entityID, byEntity);
+    }
+};
+
+template <class T>
+constexpr bool ComponentStorage<T, SortedStorage>::sorted;
+}
@@ -0,0 +1,6 @@
+#include "sparseEntityTable.h"
+
+using namespace EECS;
+
+constexpr size_t SparseEntityTable::pageSize;
+constexpr SparseEntityTable::Index SparseEntityTable::noIndex;
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include "entityID.h"
+
+namespace EECS {
+// Maps entities to positions in some dense array. Table is indexed by entityIndex and divided into lazily allocated
+// pages, so memory used by it is proportional to the range of entity indices actually used.
+class SparseEntityTable {
+    static constexpr size_t pageSize = 4096;
+
+   public:
+    using Index = uint32_t;
+    static constexpr Index noIndex = std::numeric_limits<Index>::max();
+
+    // returns position stored for the entity's index, or noIndex. Doesn't allocate.
+    // Entry could belong to other entity occupying the same index, so caller must check generation.
+    Index find(EntityID entityID) const {
+        auto page = entityIndex(entityID) / pageSize;
+        if (page >= pages.size() || !pages[page]) {
+            return noIndex;
+        }
+
+        return pages[page][entityIndex(entityID) % pageSize];
+    }
+
+    // returns reference to the entry, allocating page if necessary.
+    Index& slot(EntityID entityID) {
+        auto page = entityIndex(entityID) / pageSize;
+        if (page >= pages.size()) {
+            pages.resize(page + 1);
+        }
+
+        if (!pages[page]) {
+            pages[page].reset(new Index[pageSize]);
+            std::fill(pages[page].get(), pages[page].get() + pageSize, noIndex);
+        }
+
+        return pages[page][entityIndex(entityID) % pageSize];
+    }
+
+    void clear() { pages.clear(); }
+
+   private:
+    std::vector<std::unique_ptr<Index[]>> pages;
+};
+}
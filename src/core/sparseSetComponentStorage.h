@@ -0,0 +1,78 @@
+#pragma once
+#include <vector>
+#include "componentStorage.h"
+#include "sparseEntityTable.h"
+#include "entityID.h"
+#include "../utils/span.h"
+
+namespace EECS {
+// Stores components in a dense vector, in order of addition(modified by deletions, which move last component into the
+// hole). Position of component of given entity is kept in a SparseEntityTable.
+// Component of the entity which previously occupied the same index is considered absent and gets replaced on addition.
+template <class T>
+class ComponentStorage<T, SparseSetStorage> : public LoopedBulkOperations<ComponentStorage<T, SparseSetStorage>> {
+    using Index = SparseEntityTable::Index;
+    static constexpr Index noComponent = SparseEntityTable::noIndex;
+
+   public:
+    static constexpr bool sorted = false;
+
+    T* get(EntityID entityID) {
+        auto index = indexes.find(entityID);
+        if (index == noComponent || components[index].entityID != entityID) {
+            return nullptr;
+        }
+
+        return &components[index];
+    }
+
+    template <typename... Args>
+    T* add(EntityID entityID, Args&&... args) {
+        auto& index = indexes.slot(entityID);
+        if (index != noComponent) {
+            components[index] = T(std::forward<Args>(args)...);
+        } else {
+            index = (Index)components.size();
+            components.emplace_back(std::forward<Args>(args)...);
+        }
+
+        components[index].entityID = entityID;
+        return &components[index];
+    }
+
+    bool remove(EntityID entityID) {
+        auto index = indexes.find(entityID);
+        if (index == noComponent || components[index].entityID != entityID) {
+            return false;
+        }
+
+        if (index != components.size() - 1) {
+            components[index] = std::move(components.back());
+            indexes.slot(components[index].entityID) = index;
+        }
+        components.pop_back();
+        indexes.slot(entityID) = noComponent;
+
+        return true;
+    }
+
+    void reserveAdditional(size_t count) { components.reserve(components.size() + count); }
+
+    void clear() {
+        components.clear();
+        indexes.clear();
+    }
+
+    std::vector<T>& all() { return components; }
+
+   private:
+    std::vector<T> components;
+    SparseEntityTable indexes;
+};
+
+template <class T>
+constexpr typename ComponentStorage<T, SparseSetStorage>::Index ComponentStorage<T, SparseSetStorage>::noComponent;
+
+template <class T>
+constexpr bool ComponentStorage<T, SparseSetStorage>::sorted;
+}
@@ -1,8 +1,22 @@
 #include "task.h"
 #include "ecs.h"
+#include <algorithm>
 
 using namespace EECS;
 
 TaskBase::TaskBase(ECS& ecs) : ecs(ecs) {
     frequency = std::chrono::milliseconds(ecs.config.get("task.defaultTaskFrequency", 16));
 }
+
+bool TaskBase::conflictsWith(const TaskBase& other) const {
+    if (!accessDeclared || !other.accessDeclared) {
+        return true;
+    }
+
+    auto writesAnyOf = [](const TaskBase& task, const std::vector<size_t>& types) {
+        return std::find_first_of(task.writes.begin(), task.writes.end(), types.begin(), types.end()) !=
+               task.writes.end();
+    };
+
+    return writesAnyOf(*this, other.reads) || writesAnyOf(*this, other.writes) || writesAnyOf(other, reads);
+}
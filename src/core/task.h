@@ -1,5 +1,8 @@
 #pragma once
 #include <chrono>
+#include <vector>
+#include "componentContainerID.h"
+#include "../utils/typeName.h"
 
 namespace EECS {
 class ECS;
@@ -24,6 +27,14 @@ class TaskRegistrator {
     TaskRegistrator() { TaskID::get<T>(); }
 };
 
+/** \brief declares component types which Task reads, see Task */
+template <typename... ComponentTypes>
+struct Reads {};
+
+/** \brief declares component types which Task reads and modifies, see Task */
+template <typename... ComponentTypes>
+struct Writes {};
+
 class TaskBase {
    public:
     TaskBase(ECS& ecs);
@@ -32,10 +43,86 @@ class TaskBase {
     /** \brief called at given frequency, derived class must implement it */
     virtual void update() = 0;
 
-    std::chrono::milliseconds frequency;
-    std::chrono::milliseconds accumulatedTime{0};
+    /** \brief true if tasks can't run concurrently, because one of them writes what the other one accesses
+    *
+    * Task which didn't declare its accesses conflicts with every other task.
+    */
+    bool conflictsWith(const TaskBase& other) const;
+
+    /** \brief true if task is always updated on thread which calls TaskScheduler::update
+    *
+    * That is the case for tasks which didn't declare their accesses, and for tasks which set runsOnMainThread, for
+    * example because they use graphics API or window.
+    */
+    bool needsMainThread() const { return !accessDeclared || runsOnMainThread; }
+
+    /** \brief how task catches up when more than one period has accumulated, for example after a stall
+    *
+    *   - Unlimited: every accumulated period is updated in the same call.
+    *   - MaxSteps: at most maxCatchUpSteps updates per call, remaining periods stay accumulated for later calls.
+    *   - DropTime: at most maxCatchUpSteps updates per call, time of remaining periods is dropped.
+    *   - StretchTime: at most maxCatchUpSteps updates per call, each one covering proportionally longer stepTime, so
+    *     no time is lost, but steps get coarser.
+    *
+    *   Regardless of policy, accumulated time above maxBacklog is dropped.
+    */
+    enum class CatchUp { Unlimited, MaxSteps, DropTime, StretchTime };
+
+    // time between updates(rather period than frequency), and time accumulated towards the next update.
+    std::chrono::nanoseconds frequency;
+    std::chrono::nanoseconds accumulatedTime{0};
+
+    CatchUp catchUp = CatchUp::Unlimited;
+    size_t maxCatchUpSteps = 4;
+    std::chrono::nanoseconds maxBacklog{std::chrono::seconds(1)};
+
+    // when TaskScheduler's frame budget is exceeded, tasks with lower priority are deferred first. Task deferred
+    // maxDeferrals times in a row runs regardless of budget, so it doesn't starve.
+    int priority = 0;
+    size_t maxDeferrals = 4;
+    size_t deferredInRow = 0;
+
+    // time which current update represents: frequency, unless stretched; for task without period, time since last one.
+    std::chrono::nanoseconds stepTime{0};
+
+    // simulated time discarded by catch-up policy, backlog cap or load shedding, and number of times task was deferred
+    // because of frame budget. Average duration of single update is used to estimate cost of the frame.
+    std::chrono::nanoseconds droppedTime{0};
+    size_t deferrals = 0;
+    std::chrono::nanoseconds averageUpdateTime{0};
+
+    // task which is updated only when triggered by events, instead of at frequency, see TriggeredBy.
+    bool eventDriven = false;
+    bool triggered = false;
+
+    // keeps task which declared its accesses on the main thread, see needsMainThread.
+    bool runsOnMainThread = false;
+
+    // name of derived class, used by Profiler.
+    const char* name = "Task";
 
     ECS& ecs;
+
+   protected:
+    template <typename... ComponentTypes>
+    void declareAccess(Reads<ComponentTypes...>) {
+        using expand = int[];
+        (void)expand{0, (reads.push_back(ComponentContainerID::get<ComponentTypes>()), 0)...};
+        accessDeclared = true;
+    }
+
+    template <typename... ComponentTypes>
+    void declareAccess(Writes<ComponentTypes...>) {
+        using expand = int[];
+        (void)expand{0, (writes.push_back(ComponentContainerID::get<ComponentTypes>()), 0)...};
+        accessDeclared = true;
+    }
+
+   private:
+    // ComponentContainerIDs of declared component types.
+    std::vector<size_t> reads;
+    std::vector<size_t> writes;
+    bool accessDeclared = false;
 };
 
 /** \brief implements independient portion of code, that is executed with some frequency
@@ -52,15 +139,33 @@ class TaskBase {
 *   But Tasks are flexible, so you can use it to do any thing that should be done periodically.
 *
 *   By default, frequency will be once per game loop iteration(in config, task.defaultTaskFrequency).
+*
+*   Task can declare component types it accesses, by Reads and Writes arguments after Derived:
+*
+*   class PhysicsIntegrator : public Task<PhysicsIntegrator, Reads<BodyComponent>, Writes<PositionComponent>> {...};
+*
+*   TaskScheduler runs tasks which don't conflict(neither writes anything the other one reads or writes) concurrently,
+*   on ECS's JobSystem. Tasks without declarations are never run concurrently with other tasks, and like tasks which
+*   set runsOnMainThread, they are always run on the thread calling TaskScheduler::update. Tasks running
+*   concurrently may only modify values of components they declared as written. Adding and deleting components or
+*   entities isn't thread safe, but such changes can be recorded into ecs.commands.local() instead. Emitting events
+*   isn't thread safe either.
 */
-template <typename Derived>
+template <typename Derived, typename... Access>
 class Task : public TaskBase {
    private:
-    Task(ECS& ecs) : TaskBase(ecs) { (void)taskRegistrator; }
+    Task(ECS& ecs) : TaskBase(ecs) {
+        (void)taskRegistrator;
+        name = typeName<Derived>();
+
+        using expand = int[];
+        (void)expand{0, (declareAccess(Access()), 0)...};
+    }
+
     static TaskRegistrator<Derived> taskRegistrator;
     friend Derived;
 };
 
-template <typename Derived>
-TaskRegistrator<Derived> Task<Derived>::taskRegistrator;
+template <typename Derived, typename... Access>
+TaskRegistrator<Derived> Task<Derived, Access...>::taskRegistrator;
 }
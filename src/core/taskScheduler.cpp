@@ -1,7 +1,9 @@
 #include "taskScheduler.h"
-#include "utils/emath.h"
+#include <algorithm>
 #include "utils/timer.h"
 #include "task.h"
+#include "profiler.h"
+#include "ecs.h"
 
 using namespace EECS;
 
@@ -11,28 +13,199 @@ EECS::TaskScheduler::~TaskScheduler() = default;
 
 void EECS::TaskScheduler::clear() { tasks.clear(); }
 
-std::chrono::milliseconds EECS::TaskScheduler::update(std::chrono::milliseconds elapsedTime) {
-    std::chrono::milliseconds nextTaskUpdate{std::chrono::milliseconds::max()};
+std::chrono::nanoseconds EECS::TaskScheduler::update(std::chrono::nanoseconds elapsedTime) {
+    EECS_PROFILE_ZONE("scheduler", "TaskScheduler::update");
+    std::chrono::nanoseconds nextTaskUpdate{std::chrono::nanoseconds::max()};
     Timer timeAlreadyElapsed;
 
+    // gathers tasks which need update in this call, together with number of their updates
+    dueTasks.clear();
     for (auto& task : tasks) {
         if (task == nullptr) {
             continue;
         }
 
-        task->accumulatedTime = clamp(task->accumulatedTime + elapsedTime + timeAlreadyElapsed.elapsed(),
-                                      std::chrono::milliseconds(0), std::chrono::milliseconds(1000));
+        schedule(*task, elapsedTime);
+    }
+
+    if (frameBudget > std::chrono::nanoseconds(0) && dueTasks.size() > 1) {
+        shedLoad();
+    }
+
+    // after load shedding, so time of deferred tasks, which stays accumulated, brings their next update closer
+    for (auto& task : tasks) {
+        if (task != nullptr && !task->eventDriven) {
+            nextTaskUpdate = std::min(nextTaskUpdate, task->frequency - task->accumulatedTime);
+        }
+    }
 
-        while (task->accumulatedTime >= task->frequency) {
-            task->update();
-            task->accumulatedTime -= task->frequency;
+    // tasks which need main thread split due tasks into segments, which are run in order of IDs; tasks between them
+    // are run concurrently where they don't conflict
+    Timer updateTime;
+    size_t segmentBegin = 0;
+    for (auto i = 0u; i <= dueTasks.size(); i++) {
+        if (i < dueTasks.size() && !dueTasks[i].task->needsMainThread()) {
+            continue;
         }
 
-        if (nextTaskUpdate - timeAlreadyElapsed.elapsed() > task->frequency - task->accumulatedTime) {
-            nextTaskUpdate = task->frequency - task->accumulatedTime;
-            timeAlreadyElapsed.reset();
+        runConcurrently(segmentBegin, i);
+        if (i < dueTasks.size()) {
+            run(dueTasks[i]);
         }
+        segmentBegin = i + 1;
+    }
+
+    if (frameBudget > std::chrono::nanoseconds(0) && updateTime.elapsed() > frameBudget) {
+        statistics.overBudgetFrames++;
+    }
+
+    if (!dueTasks.empty()) {
+        engine.commands.playback();
+    }
+
+    if (nextTaskUpdate == std::chrono::nanoseconds::max()) {
+        return nextTaskUpdate;
     }
 
     return nextTaskUpdate - timeAlreadyElapsed.elapsed();
 }
+
+void EECS::TaskScheduler::runConcurrently(size_t begin, size_t end) {
+    if (end - begin < 2) {
+        if (begin < end) {
+            run(dueTasks[begin]);
+        }
+        return;
+    }
+
+    // conflicting tasks are run in order of their IDs, like they would be run sequentially
+    dependencies.resize(end - begin);
+    for (auto i = begin; i < end; i++) {
+        auto& successors = dependencies[i - begin];
+        successors.clear();
+        for (auto j = i + 1; j < end; j++) {
+            if (dueTasks[i].task->conflictsWith(*dueTasks[j].task)) {
+                successors.push_back(j - begin);
+            }
+        }
+    }
+
+    engine.jobs.runGraph(dependencies, [this, begin](size_t node) { run(dueTasks[begin + node]); });
+}
+
+void EECS::TaskScheduler::run(DueTask& due) {
+    EECS_PROFILE_ZONE("task", due.task->name);
+    Timer timer;
+    due.task->deferredInRow = 0;
+    due.task->stepTime = due.step;
+    for (auto i = 0u; i < due.updates; i++) {
+        due.task->update();
+    }
+
+    auto averageTime = timer.elapsed() / (int64_t)due.updates;
+    auto& average = due.task->averageUpdateTime;
+    average = average == std::chrono::nanoseconds(0) ? averageTime : (average * 7 + averageTime) / 8;
+}
+
+void EECS::TaskScheduler::schedule(TaskBase& task, std::chrono::nanoseconds elapsedTime) {
+    // event driven task accumulates time since its last update, without a cap
+    if (task.eventDriven) {
+        task.accumulatedTime += elapsedTime;
+        if (task.triggered) {
+            task.triggered = false;
+            dueTasks.push_back({&task, 1, task.accumulatedTime});
+            task.accumulatedTime = std::chrono::nanoseconds(0);
+        }
+        return;
+    }
+
+    task.accumulatedTime = std::max(task.accumulatedTime + elapsedTime, std::chrono::nanoseconds(0));
+    if (task.accumulatedTime > task.maxBacklog) {
+        drop(task, task.accumulatedTime - task.maxBacklog);
+        task.accumulatedTime = task.maxBacklog;
+    }
+
+    // task without positive period is updated once per call
+    if (task.frequency <= std::chrono::nanoseconds(0)) {
+        dueTasks.push_back({&task, 1, task.accumulatedTime});
+        task.accumulatedTime = std::chrono::nanoseconds(0);
+        return;
+    }
+
+    auto periods = (size_t)(task.accumulatedTime / task.frequency);
+    auto updates = periods;
+    auto step = task.frequency;
+    auto maxSteps = std::max<size_t>(task.maxCatchUpSteps, 1);
+    if (task.catchUp == TaskBase::CatchUp::Unlimited || periods <= maxSteps) {
+        task.accumulatedTime %= task.frequency;
+    } else {
+        updates = maxSteps;
+        switch (task.catchUp) {
+            case TaskBase::CatchUp::MaxSteps:
+                task.accumulatedTime -= task.frequency * (int64_t)updates;
+                break;
+            case TaskBase::CatchUp::DropTime:
+                drop(task, task.frequency * (int64_t)(periods - updates));
+                task.accumulatedTime %= task.frequency;
+                break;
+            default:
+                // what doesn't divide evenly into stretched steps stays accumulated
+                step = task.frequency * (int64_t)periods / (int64_t)updates;
+                task.accumulatedTime %= task.frequency;
+                task.accumulatedTime += task.frequency * (int64_t)periods - step * (int64_t)updates;
+                break;
+        }
+    }
+
+    if (updates > 0) {
+        dueTasks.push_back({&task, updates, step});
+    }
+}
+
+void EECS::TaskScheduler::drop(TaskBase& task, std::chrono::nanoseconds time) {
+    task.droppedTime += time;
+    statistics.droppedTime += time;
+}
+
+void EECS::TaskScheduler::shedLoad() {
+    admission.resize(dueTasks.size());
+    for (auto i = 0u; i < dueTasks.size(); i++) {
+        admission[i] = i;
+    }
+
+    std::stable_sort(admission.begin(), admission.end(),
+                     [this](size_t a, size_t b) { return dueTasks[a].task->priority > dueTasks[b].task->priority; });
+
+    // cost is estimated as if tasks ran sequentially, so with concurrent tasks it errs on the safe side
+    std::chrono::nanoseconds cost{0};
+    for (auto i = 0u; i < admission.size(); i++) {
+        auto& due = dueTasks[admission[i]];
+        auto estimate = due.task->averageUpdateTime * (int64_t)due.updates;
+        if (i == 0 || cost + estimate <= frameBudget || due.task->deferredInRow >= due.task->maxDeferrals) {
+            cost += estimate;
+            continue;
+        }
+
+        auto deferredTime = due.step * (int64_t)due.updates;
+        due.task->triggered = due.task->eventDriven;
+        if (due.task->catchUp == TaskBase::CatchUp::DropTime && !due.task->eventDriven) {
+            drop(*due.task, deferredTime);
+        } else {
+            due.task->accumulatedTime += deferredTime;
+        }
+
+        due.task->deferrals++;
+        due.task->deferredInRow++;
+        statistics.deferrals++;
+        due.updates = 0;
+    }
+
+    auto deferred = [](const DueTask& due) { return due.updates == 0; };
+    dueTasks.erase(std::remove_if(dueTasks.begin(), dueTasks.end(), deferred), dueTasks.end());
+}
+
+bool EECS::TaskScheduler::hasTriggeredTasks() const {
+    return std::any_of(tasks.begin(), tasks.end(), [](const std::unique_ptr<TaskBase>& task) {
+        return task && task->eventDriven && task->triggered;
+    });
+}
@@ -12,7 +12,14 @@ class TaskBase;
 *
 *  It is more flexible version of traditional game loop.
 *  It uses fixed timestep approach.
-*  Any Task can have different frequency - so, for example, physics can be 100Hz, rendering 30Hz, and ai 2Hz.
+*  Any Task can have different frequency - so, for example, physics can be 100Hz, rendering 30Hz, and ai 2Hz. Time is
+*  measured in nanoseconds, so frequencies above 1kHz work too.
+*
+*  Each update, tasks which are due form a dependency graph: a task waits for tasks with lower ID it conflicts with
+*  (see Task about Reads and Writes declarations). The graph is run on ECS's JobSystem, so independent tasks update
+*  concurrently. Tasks which need main thread(see TaskBase::needsMainThread) are run on the calling thread instead,
+*  after all due tasks with lower ID and before all with higher ID. Then changes recorded in ECS's CommandBuffers are
+*  played back.
 */
 class TaskScheduler {
    public:
@@ -52,12 +59,61 @@ class TaskScheduler {
     *
     *   \param elapsedTime time that has passed since last call of this method
     *
-    *   \returns amount of time when it doesn't need to be called again(interval to time when any task needs update)
+    *   Time is accumulated in nanoseconds and whole periods are subtracted from it, so no time is lost to rounding and
+    *   tasks update exactly as many times as their periods fit into total elapsed time. After a stall, task catches
+    *   up according to its catch-up policy, and never with more than its maxBacklog worth of time(see TaskBase).
+    *
+    *   If frame budget is set, estimated cost of due tasks(their average update time times number of updates) is
+    *   summed in order of priority, and tasks which don't fit are deferred to the next call: their time stays
+    *   accumulated, or is dropped if their catch-up policy is DropTime. Task with the highest priority always runs, and
+    *   so does task which was deferred maxDeferrals times in a row.
+    *
+    *   Event driven tasks(see TriggeredBy) are updated once if they were triggered, and don't count towards returned
+    *   time.
+    *
+    *   \returns amount of time when it doesn't need to be called again(interval to time when any task needs update),
+    *   maximum duration if no task needs polling
     */
-    std::chrono::milliseconds update(std::chrono::milliseconds elapsedTime);
+    std::chrono::nanoseconds update(std::chrono::nanoseconds elapsedTime);
+
+    // true if any event driven task was triggered since the last update(see TriggeredBy), so it should be called soon.
+    bool hasTriggeredTasks() const;
+
+    /** \brief sets time which updating tasks in single call should fit in; zero(default) disables load shedding */
+    void setFrameBudget(std::chrono::nanoseconds budget) { frameBudget = budget; }
+    std::chrono::nanoseconds getFrameBudget() const { return frameBudget; }
+
+    struct Statistics {
+        std::chrono::nanoseconds droppedTime{0};  // simulated time dropped by all tasks
+        size_t deferrals = 0;                     // tasks deferred because they didn't fit into frame budget
+        size_t overBudgetFrames = 0;              // calls in which updating tasks took longer than frame budget
+    };
+
+    const Statistics& getStatistics() const { return statistics; }
+    void resetStatistics() { statistics = Statistics(); }
 
    private:
+    struct DueTask {
+        TaskBase* task;
+        size_t updates;
+        std::chrono::nanoseconds step;
+    };
+
+    void schedule(TaskBase& task, std::chrono::nanoseconds elapsedTime);
+    void drop(TaskBase& task, std::chrono::nanoseconds time);
+    void shedLoad();
+    void runConcurrently(size_t begin, size_t end);
+    void run(DueTask& due);
+
     std::vector<std::unique_ptr<TaskBase>> tasks;
     ECS& engine;
+
+    // state of the current update call, kept to reuse memory.
+    std::vector<DueTask> dueTasks;
+    std::vector<std::vector<size_t>> dependencies;  // dependencies[i] lists tasks of segment which wait for i-th one
+    std::vector<size_t> admission;                  // indices of due tasks, by priority
+
+    std::chrono::nanoseconds frameBudget{0};
+    Statistics statistics;
 };
 }
@@ -0,0 +1,128 @@
+#include "timingWheel.h"
+#include <algorithm>
+
+using namespace EECS;
+
+constexpr size_t TimingWheel::levelCount;
+constexpr size_t TimingWheel::slotBits;
+constexpr size_t TimingWheel::slotCount;
+constexpr uint64_t TimingWheel::slotMask;
+constexpr uint32_t TimingWheel::noNode;
+
+TimingWheel::TimingWheel() {
+    for (auto& level : slots) {
+        level.fill(noNode);
+    }
+}
+
+TimerID TimingWheel::add(uint64_t deadline, uint64_t data) {
+    uint32_t node;
+    if (!freeNodes.empty()) {
+        node = freeNodes.back();
+        freeNodes.pop_back();
+    } else {
+        node = (uint32_t)nodes.size();
+        nodes.emplace_back();
+    }
+
+    nodes[node].deadline = std::max(deadline, tick + 1);
+    nodes[node].data = data;
+    insert(node);
+    timerCount++;
+
+    // generation is offset by one, so TimerID is never 0
+    return ((uint64_t)(nodes[node].generation + 1) << 32) | node;
+}
+
+bool TimingWheel::cancel(TimerID timer, uint64_t& data) {
+    auto node = (uint32_t)timer;
+    if (node >= nodes.size() || !nodes[node].head || (uint64_t)(nodes[node].generation + 1) != timer >> 32) {
+        return false;
+    }
+
+    data = nodes[node].data;
+    unlink(node);
+    release(node);
+    return true;
+}
+
+uint64_t TimingWheel::ticksUntilNext() const {
+    if (timerCount == 0) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+    // level 0 holds timers due within the next slotCount ticks, each in slot of its deadline
+    for (auto ticks = 1u; ticks < slotCount; ticks++) {
+        if (slots[0][(tick + ticks) & slotMask] != noNode) {
+            return ticks;
+        }
+    }
+
+    return slotCount - (tick & slotMask);
+}
+
+void TimingWheel::insert(uint32_t node) {
+    auto deadline = nodes[node].deadline;
+    auto distance = deadline - tick;
+
+    // too distant timers are put into the last slot within range, and cascaded further down once they get there
+    if (distance >> (slotBits * levelCount)) {
+        distance = (1ull << (slotBits * levelCount)) - 1;
+        deadline = tick + distance;
+    }
+
+    auto level = 0u;
+    while (distance >> (slotBits * (level + 1))) {
+        level++;
+    }
+
+    auto& head = slots[level][(deadline >> (slotBits * level)) & slotMask];
+    nodes[node].head = &head;
+    nodes[node].previous = noNode;
+    nodes[node].next = head;
+    if (head != noNode) {
+        nodes[head].previous = node;
+    }
+    head = node;
+}
+
+void TimingWheel::unlink(uint32_t node) {
+    auto& entry = nodes[node];
+    if (entry.previous != noNode) {
+        nodes[entry.previous].next = entry.next;
+    } else {
+        *entry.head = entry.next;
+    }
+
+    if (entry.next != noNode) {
+        nodes[entry.next].previous = entry.previous;
+    }
+
+    entry.head = nullptr;
+}
+
+void TimingWheel::release(uint32_t node) {
+    // when generation wraps around, node is retired for good, like entity slots
+    if (++nodes[node].generation + 1 != 0) {
+        freeNodes.push_back(node);
+    }
+    timerCount--;
+}
+
+void TimingWheel::cascade() {
+    for (auto level = 1u; level < levelCount; level++) {
+        // upper level slot is due only when all levels below it wrapped around
+        if ((tick >> (slotBits * (level - 1))) & slotMask) {
+            return;
+        }
+
+        auto& head = slots[level][(tick >> (slotBits * level)) & slotMask];
+        auto node = head;
+        head = noNode;
+        while (node != noNode) {
+            auto next = nodes[node].next;
+            insert(node);
+            node = next;
+        }
+    }
+}
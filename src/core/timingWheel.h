@@ -0,0 +1,108 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+namespace EECS {
+// identifies timer in TimingWheel. Index of the timer in low 32 bits, generation in high ones, so identifiers of fired
+// or cancelled timers stay invalid even if their slot is reused. 0 is never a valid TimerID.
+using TimerID = uint64_t;
+
+/** \brief hierarchical timing wheel: set of timers expiring at given ticks, with O(1) insertion and cancellation
+*
+* There are 4 levels of 256 slots. Timer due in less than 256 ticks is kept in level 0 slot of its deadline; due in less
+* than 2^16 ticks, in level 1 slot of deadline / 256, and so on. Each time lower level wraps around, timers from the
+* next slot of upper level are moved down(cascaded). Timers due later than 2^32 ticks ahead wait in the last level and
+* are cascaded until they're close enough.
+*
+* Each timer carries 64 bits of user data, passed back when it expires or is cancelled.
+*/
+class TimingWheel {
+   public:
+    TimingWheel();
+
+    // adds timer expiring at given tick. Timers due at or before current tick expire at the next one.
+    TimerID add(uint64_t deadline, uint64_t data);
+
+    // removes timer, writing its data to the second argument. Returns false if timer already expired or was cancelled.
+    bool cancel(TimerID timer, uint64_t& data);
+
+    // moves time forward by given number of ticks, calling expired(data) for every timer which expired, in order of
+    // deadlines(timers due at the same tick in unspecified order).
+    template <class Function>
+    void advance(uint64_t ticks, Function&& expired) {
+        for (; ticks > 0; ticks--) {
+            if (timerCount == 0) {
+                tick += ticks;
+                return;
+            }
+
+            tick++;
+            cascade();
+
+            auto& head = slots[0][tick & slotMask];
+            while (head != noNode) {
+                auto node = head;
+                auto data = nodes[node].data;
+                unlink(node);
+                release(node);
+                expired(data);
+            }
+        }
+    }
+
+    uint64_t currentTick() const { return tick; }
+
+    // number of pending timers.
+    size_t size() const { return timerCount; }
+
+    // number of ticks after which the next timer expires: exact if it's in level 0, otherwise a lower bound(ticks until
+    // timers from upper levels are cascaded down). Maximum value if there are no timers.
+    uint64_t ticksUntilNext() const;
+
+    // deletes all timers, calling dropped(data) for each of them.
+    template <class Function>
+    void clear(Function&& dropped) {
+        for (auto node = 0u; node < nodes.size(); node++) {
+            if (nodes[node].head) {
+                auto data = nodes[node].data;
+                unlink(node);
+                release(node);
+                dropped(data);
+            }
+        }
+    }
+
+   private:
+    static constexpr size_t levelCount = 4;
+    static constexpr size_t slotBits = 8;
+    static constexpr size_t slotCount = 1 << slotBits;
+    static constexpr uint64_t slotMask = slotCount - 1;
+    static constexpr uint32_t noNode = std::numeric_limits<uint32_t>::max();
+
+    struct Node {
+        uint64_t deadline = 0;
+        uint64_t data = 0;
+        uint32_t generation = 0;
+        uint32_t previous = noNode;
+        uint32_t next = noNode;
+        uint32_t* head = nullptr;  // slot which the node is in, nullptr if it isn't pending
+    };
+
+    std::array<std::array<uint32_t, slotCount>, levelCount> slots;  // heads of doubly linked lists of nodes
+    std::vector<Node> nodes;
+    std::vector<uint32_t> freeNodes;
+    uint64_t tick = 0;
+    size_t timerCount = 0;
+
+    // puts node into the slot corresponding to its deadline, relative to current tick.
+    void insert(uint32_t node);
+    void unlink(uint32_t node);
+    void release(uint32_t node);
+
+    // moves timers from upper levels' slots corresponding to the current tick to lower levels.
+    void cascade();
+};
+}
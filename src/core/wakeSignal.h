@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace EECS {
+/** \brief lets any thread interrupt waiting of another one, see FramePacer
+*
+* Notification stays pending until it's consumed by wait or poll, so it isn't lost when it comes before waiting
+* begins. Notifying when notification is already pending is a single relaxed load, and the mutex is only taken when
+* some thread is actually waiting, so notify can be called on every pushed event.
+*/
+class WakeSignal {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    void notify() {
+        if (pending.load(std::memory_order_relaxed) || pending.exchange(true)) {
+            return;
+        }
+
+        if (waiting.load()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            condition.notify_one();
+        }
+    }
+
+    // drops pending notification.
+    void reset() { pending.store(false); }
+
+    // consumes pending notification, returns whether there was one.
+    bool poll() { return pending.load(std::memory_order_relaxed) && pending.exchange(false); }
+
+    // waits until deadline or notification, whichever comes first. Returns true if it was woken up by notification.
+    bool waitUntil(Clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(mutex);
+        waiting.store(true);
+        while (!pending.load() && Clock::now() < deadline) {
+            condition.wait_until(lock, deadline);
+        }
+        waiting.store(false);
+
+        return pending.exchange(false);
+    }
+
+   private:
+    std::atomic<bool> pending{false};
+    std::atomic<bool> waiting{false};
+    std::mutex mutex;
+    std::condition_variable condition;
+};
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+/** \brief allocator returning memory aligned to Alignment bytes, for ex. to let std::vector hold SIMD-friendly arrays.
+*
+* Alignment must be a power of 2. Allocates Alignment bytes more than requested and keeps pointer to the whole block
+* right before the returned address.
+*/
+template <class T, size_t Alignment>
+class AlignedAllocator {
+    static_assert(Alignment >= alignof(void*) && (Alignment & (Alignment - 1)) == 0,
+                  "Alignment must be a power of 2, not smaller than alignment of a pointer");
+
+   public:
+    using value_type = T;
+
+    template <class U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <class U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t count) {
+        auto block = (char*)::operator new(count * sizeof(T) + Alignment);
+        auto aligned = (char*)(((uintptr_t)block + Alignment) & ~(uintptr_t)(Alignment - 1));
+        ((void**)aligned)[-1] = block;
+        return (T*)aligned;
+    }
+
+    void deallocate(T* pointer, size_t) { ::operator delete(((void**)pointer)[-1]); }
+
+    template <class U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const {
+        return true;
+    }
+
+    template <class U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const {
+        return false;
+    }
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+/** \brief bounded lock-free queue with many producers and a single consumer
+*
+* Array of cells, each with a sequence number telling whether it's free for the producer which reserved given position,
+* or holds published element for the consumer(D. Vyukov's bounded queue). Producers reserve positions with CAS, so
+* elements are ordered by the time of reservation. Capacity must be a power of 2.
+*/
+template <class T>
+class MPSCRing {
+   public:
+    explicit MPSCRing(size_t capacity) : cells(new Cell[capacity]), mask(capacity - 1) {
+        for (auto i = 0u; i < capacity; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MPSCRing() {
+        drain([](T&&) {});
+    }
+
+    MPSCRing(const MPSCRing&) = delete;
+    MPSCRing& operator=(const MPSCRing&) = delete;
+
+    /** \brief constructs element at the end of the queue. Returns false if queue is full. Safe to call concurrently. */
+    template <class... Args>
+    bool tryPush(Args&&... args) {
+        auto position = enqueuePosition.load(std::memory_order_relaxed);
+        Cell* cell;
+
+        while (true) {
+            cell = &cells[position & mask];
+            auto sequence = cell->sequence.load(std::memory_order_acquire);
+            auto difference = (intptr_t)sequence - (intptr_t)position;
+
+            if (difference == 0) {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        new (&cell->storage) T(std::forward<Args>(args)...);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** \brief passes published elements to function(T&&), in order, until it reaches the end or an element which is
+    * still being pushed. Returns number of consumed elements. Only one thread can consume at a time.
+    */
+    template <class Function>
+    size_t drain(Function&& function) {
+        size_t consumed = 0;
+
+        while (true) {
+            auto& cell = cells[dequeuePosition & mask];
+            if (cell.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) {
+                return consumed;
+            }
+
+            auto element = (T*)&cell.storage;
+            function(std::move(*element));
+            element->~T();
+
+            cell.sequence.store(dequeuePosition + mask + 1, std::memory_order_release);
+            dequeuePosition++;
+            consumed++;
+        }
+    }
+
+    /** \brief true if there's no element in the queue, including elements being pushed. */
+    bool empty() const { return enqueuePosition.load(std::memory_order_acquire) == dequeuePosition; }
+
+   private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    const size_t mask;
+
+    // producers and consumer touch different positions, so they're kept on separate cache lines.
+    char padding[64];
+    std::atomic<size_t> enqueuePosition{0};
+    char otherPadding[64];
+    size_t dequeuePosition = 0;
+};
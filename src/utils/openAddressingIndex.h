@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+/** \brief map from 64-bit keys to 32-bit values, in a single power-of-2 table with linear probing
+*
+* Slots are stamped with the epoch in which they were filled, so clear() just bumps the epoch - O(1), no matter how
+* big the table got. Table doubles when it becomes half full.
+*/
+class OpenAddressingIndex {
+   public:
+    /** \brief returns value stored under the key, storing given one first if there is none. Second is true if it was
+    * stored. */
+    std::pair<uint32_t, bool> findOrInsert(uint64_t key, uint32_t value) {
+        if ((count + 1) * 2 > slots.size()) {
+            grow();
+        }
+
+        auto mask = slots.size() - 1;
+        for (auto position = hash(key) & mask;; position = (position + 1) & mask) {
+            auto& slot = slots[position];
+            if (slot.epoch != epoch) {
+                slot = {key, value, epoch};
+                count++;
+                return {value, true};
+            }
+
+            if (slot.key == key) {
+                return {slot.value, false};
+            }
+        }
+    }
+
+    void clear() {
+        count = 0;
+        if (++epoch == 0) {  // stamps of old slots could match again, so they have to be wiped
+            for (auto& slot : slots) {
+                slot.epoch = 0;
+            }
+            epoch = 1;
+        }
+    }
+
+    size_t size() const { return count; }
+
+   private:
+    struct Slot {
+        uint64_t key;
+        uint32_t value;
+        uint32_t epoch;  // slot is empty unless it's equal to the current epoch
+    };
+
+    std::vector<Slot> slots;
+    uint32_t epoch = 1;
+    size_t count = 0;
+
+    // finalizer of splitmix64, so keys differing only in high bits(like generations of EntityIDs) spread too.
+    static uint64_t hash(uint64_t key) {
+        key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+        key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+        return key ^ (key >> 31);
+    }
+
+    void grow() {
+        auto old = std::move(slots);
+        slots.assign(old.empty() ? 16 : old.size() * 2, Slot{0, 0, 0});
+
+        auto oldEpoch = epoch;
+        epoch = 1;
+        count = 0;
+        for (const auto& slot : old) {
+            if (slot.epoch == oldEpoch) {
+                findOrInsert(slot.key, slot.value);
+            }
+        }
+    }
+};
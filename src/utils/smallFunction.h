@@ -0,0 +1,85 @@
+#pragma once
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+
+template <class Signature, size_t Capacity = 4 * sizeof(void*)>
+class SmallFunction;
+
+/** \brief type-erased callable stored inline, in a buffer of Capacity bytes
+*
+* Like std::function, but never allocates: callable which doesn't fit into the buffer is a compile error. Move-only,
+* so callables capturing move-only objects can be stored too.
+*/
+template <class R, class... Args, size_t Capacity>
+class SmallFunction<R(Args...), Capacity> {
+   public:
+    SmallFunction() = default;
+
+    template <class F, class = std::enable_if_t<!std::is_same<std::decay_t<F>, SmallFunction>::value>>
+    SmallFunction(F&& function) {
+        using Callable = std::decay_t<F>;
+        static_assert(sizeof(Callable) <= Capacity, "Callable doesn't fit into SmallFunction's buffer");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t), "Over-aligned callables can't be stored");
+
+        new (&storage) Callable(std::forward<F>(function));
+        operations = operationsOf<Callable>();
+    }
+
+    SmallFunction(SmallFunction&& other) { moveFrom(other); }
+
+    SmallFunction& operator=(SmallFunction&& other) {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    SmallFunction(const SmallFunction&) = delete;
+    SmallFunction& operator=(const SmallFunction&) = delete;
+
+    ~SmallFunction() { reset(); }
+
+    R operator()(Args... args) { return operations->call(&storage, std::forward<Args>(args)...); }
+
+    explicit operator bool() const { return operations != nullptr; }
+
+   private:
+    struct Operations {
+        R (*call)(void* callable, Args&&... args);
+        void (*relocate)(void* destination, void* source);  // move-constructs destination, destroys source
+        void (*destroy)(void* callable);
+    };
+
+    typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type storage;
+    const Operations* operations = nullptr;
+
+    template <class Callable>
+    static const Operations* operationsOf() {
+        static const Operations callableOperations{
+            [](void* callable, Args&&... args) -> R { return (*(Callable*)callable)(std::forward<Args>(args)...); },
+            [](void* destination, void* source) {
+                new (destination) Callable(std::move(*(Callable*)source));
+                ((Callable*)source)->~Callable();
+            },
+            [](void* callable) { ((Callable*)callable)->~Callable(); }};
+        return &callableOperations;
+    }
+
+    void moveFrom(SmallFunction& other) {
+        if (other.operations) {
+            other.operations->relocate(&storage, &other.storage);
+            operations = other.operations;
+            other.operations = nullptr;
+        }
+    }
+
+    void reset() {
+        if (operations) {
+            operations->destroy(&storage);
+            operations = nullptr;
+        }
+    }
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+
+/** \brief non-owning view of a contiguous array, like std::span from C++20. */
+template <class T>
+class Span {
+   public:
+    Span() = default;
+    Span(T* data, size_t size) : first(data), count(size) {}
+
+    /** \brief views elements of contiguous container, like std::vector. */
+    template <class Container,
+              class = std::enable_if_t<!std::is_same<std::decay_t<Container>, Span>::value>>
+    Span(Container& container) : first(container.data()), count(container.size()) {}
+
+    T* data() const { return first; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    T* begin() const { return first; }
+    T* end() const { return first + count; }
+
+    T& operator[](size_t index) const { return first[index]; }
+
+    /** \brief returns view of count elements starting at offset. */
+    Span subspan(size_t offset, size_t count) const { return Span(first + offset, count); }
+
+   private:
+    T* first = nullptr;
+    size_t count = 0;
+};
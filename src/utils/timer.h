@@ -2,25 +2,29 @@
 
 #include <chrono>
 
+/** \brief measures time on steady clock, with its full(usually nanosecond) resolution */
 class Timer {
    public:
+    using Clock = std::chrono::steady_clock;
+
     /** \brief default constructor that starts timer immmediately */
-    Timer() : startTime(std::chrono::high_resolution_clock::now()){};
+    Timer() : startTime(Clock::now()){};
 
     /** \brief returns elapsed time without restarting Timer. */
-    std::chrono::milliseconds elapsed() {
-        std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
-        auto elapsedTime = now - startTime;
-        return std::chrono::duration_cast<std::chrono::milliseconds>(elapsedTime);
-    }
+    std::chrono::nanoseconds elapsed() const { return Clock::now() - startTime; }
 
-    /** \brief returns elaped time and restarts Timer that it will start counting from 0. */
-    std::chrono::milliseconds reset() {
-        std::chrono::milliseconds elapsedTime = elapsed();
-        startTime = std::chrono::high_resolution_clock::now();
+    /** \brief returns elaped time and restarts Timer that it will start counting from 0.
+    *
+    * Timer restarts from the same moment that ends returned duration, so durations returned by consecutive calls add
+    * up to the total time, without gaps.
+    */
+    std::chrono::nanoseconds reset() {
+        auto now = Clock::now();
+        auto elapsedTime = now - startTime;
+        startTime = now;
         return elapsedTime;
     }
 
    private:
-    std::chrono::high_resolution_clock::time_point startTime;
+    Clock::time_point startTime;
 };
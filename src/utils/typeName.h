@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include <typeinfo>
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+/** \brief turns name from type_info into human readable one, where compiler allows it */
+inline std::string demangle(const char* name) {
+#if defined(__GNUG__)
+    auto status = 0;
+    auto demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (status == 0 && demangled) {
+        std::string result(demangled);
+        std::free(demangled);
+        return result;
+    }
+#endif
+    return name;
+}
+
+/** \brief returns readable name of given type, or names of given types joined with ", "
+*
+* Computed once per list of types, so returned pointer is valid until the end of the program.
+*/
+template <typename... Types>
+const char* typeName() {
+    static const std::string name = []() {
+        std::string result;
+        using expand = int[];
+        (void)expand{0, (result += (result.empty() ? "" : ", ") + demangle(typeid(Types).name()), 0)...};
+        return result;
+    }();
+    return name.c_str();
+}
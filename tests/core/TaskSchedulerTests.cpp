@@ -1,4 +1,8 @@
 #include <catch.hpp>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <algorithm>
 #include "ecs/ecs.h"
 using namespace EECS;
 
@@ -96,9 +100,9 @@ TEST_CASE("Time to next task update with single task returns approx. task freq -
 
     auto timeToNextUpdate = taskManager.update(std::chrono::milliseconds(3));
 
-    // time that passed since last task update should be substracted, but std::chrono::milliseconds is integer so
-    // this negligable(in this case) amount of time will be discarded anyway.
-    REQUIRE(timeToNextUpdate.count() == 10 - 3);
+    // time that passed during update itself is substracted too
+    REQUIRE(timeToNextUpdate <= std::chrono::milliseconds(10 - 3));
+    REQUIRE(timeToNextUpdate > std::chrono::milliseconds(10 - 3 - 1));
 }
 
 TEST_CASE("Time to next task update with single task returns approx. tasks(min(task.freq - task.accumulatedTime))") {
@@ -112,9 +116,9 @@ TEST_CASE("Time to next task update with single task returns approx. tasks(min(t
 
     auto timeToNextUpdate = taskManager.update(std::chrono::milliseconds(100));
 
-    // time that passed since last task update should be substracted, but std::chrono::milliseconds is integer so
-    // this negligable(in this case) amount of time will be discarded anyway.
-    REQUIRE(timeToNextUpdate.count() == 1);
+    // time that passed during update itself is substracted too
+    REQUIRE(timeToNextUpdate <= std::chrono::milliseconds(1));
+    REQUIRE(timeToNextUpdate > std::chrono::milliseconds(0));
 }
 
 TEST_CASE("Task retrieval and delete test") {
@@ -130,3 +134,448 @@ TEST_CASE("Task retrieval and delete test") {
     taskManager.deleteTask<TestTask>();
     REQUIRE(!taskManager.getTask<TestTask>());
 }
+
+struct TaskTestPosition : Component<TaskTestPosition> {};
+struct TaskTestVelocity : Component<TaskTestVelocity> {};
+
+// Tasks which record order of their updates and detect whether they were running concurrently with each other.
+struct TaskProbe {
+    std::atomic<int> running{0};
+    std::atomic<bool> overlapped{false};
+    std::mutex mutex;
+    std::vector<size_t> order;
+
+    // waits a bit for other task to start, so concurrent execution is detected reliably.
+    void run(size_t taskID) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(taskID);
+        }
+
+        if (++running > 1) {
+            overlapped = true;
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+        while (!overlapped && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+        running--;
+    }
+};
+
+class PositionWriter : public Task<PositionWriter, Writes<TaskTestPosition>> {
+   public:
+    PositionWriter(ECS& engine, TaskProbe& probe) : Task(engine), probe(probe) {
+        frequency = std::chrono::milliseconds(1);
+    }
+
+    void update() { probe.run(TaskID::get<PositionWriter>()); }
+
+    TaskProbe& probe;
+};
+
+class PositionReader : public Task<PositionReader, Reads<TaskTestPosition>> {
+   public:
+    PositionReader(ECS& engine, TaskProbe& probe) : Task(engine), probe(probe) {
+        frequency = std::chrono::milliseconds(1);
+    }
+
+    void update() { probe.run(TaskID::get<PositionReader>()); }
+
+    TaskProbe& probe;
+};
+
+class OtherPositionReader : public Task<OtherPositionReader, Reads<TaskTestPosition>> {
+   public:
+    OtherPositionReader(ECS& engine, TaskProbe& probe) : Task(engine), probe(probe) {
+        frequency = std::chrono::milliseconds(1);
+    }
+
+    void update() { probe.run(TaskID::get<OtherPositionReader>()); }
+
+    TaskProbe& probe;
+};
+
+class VelocityWriter : public Task<VelocityWriter, Reads<TaskTestPosition>, Writes<TaskTestVelocity>> {
+   public:
+    VelocityWriter(ECS& engine, TaskProbe& probe) : Task(engine), probe(probe) {
+        frequency = std::chrono::milliseconds(1);
+    }
+
+    void update() { probe.run(TaskID::get<VelocityWriter>()); }
+
+    TaskProbe& probe;
+};
+
+class UndeclaredTask : public Task<UndeclaredTask> {
+   public:
+    UndeclaredTask(ECS& engine, TaskProbe& probe) : Task(engine), probe(probe) {
+        frequency = std::chrono::milliseconds(1);
+    }
+
+    void update() { probe.run(TaskID::get<UndeclaredTask>()); }
+
+    TaskProbe& probe;
+};
+
+TEST_CASE("Conflicts between tasks are determined by declared reads and writes", "[TaskScheduler]") {
+    ECS engine;
+    TaskProbe probe;
+
+    PositionWriter positionWriter(engine, probe);
+    PositionReader positionReader(engine, probe);
+    OtherPositionReader otherPositionReader(engine, probe);
+    VelocityWriter velocityWriter(engine, probe);
+    UndeclaredTask undeclared(engine, probe);
+
+    REQUIRE(positionWriter.conflictsWith(positionReader));
+    REQUIRE(positionReader.conflictsWith(positionWriter));
+    REQUIRE(positionWriter.conflictsWith(velocityWriter));
+    REQUIRE_FALSE(positionReader.conflictsWith(otherPositionReader));
+    REQUIRE_FALSE(positionReader.conflictsWith(velocityWriter));
+    REQUIRE(undeclared.conflictsWith(positionReader));
+    REQUIRE(otherPositionReader.conflictsWith(undeclared));
+}
+
+TEST_CASE("Tasks which don't conflict are run concurrently", "[TaskScheduler]") {
+    ECS engine;
+    engine.jobs.start(2);
+    TaskScheduler taskManager(engine);
+    TaskProbe probe;
+
+    taskManager.addTask<PositionReader>(probe);
+    taskManager.addTask<VelocityWriter>(probe);
+    taskManager.update(std::chrono::milliseconds(1));
+
+    REQUIRE(probe.order.size() == 2);
+    REQUIRE(probe.overlapped);
+}
+
+TEST_CASE("Conflicting tasks are run one after another, in order of their IDs", "[TaskScheduler]") {
+    ECS engine;
+    engine.jobs.start(2);
+    TaskScheduler taskManager(engine);
+    TaskProbe probe;
+
+    taskManager.addTask<PositionWriter>(probe);
+    taskManager.addTask<PositionReader>(probe);
+    taskManager.addTask<UndeclaredTask>(probe);
+    taskManager.update(std::chrono::milliseconds(2));
+
+    std::vector<size_t> expected = {TaskID::get<PositionWriter>(), TaskID::get<PositionReader>(),
+                                    TaskID::get<UndeclaredTask>()};
+    std::sort(expected.begin(), expected.end());
+    expected.insert(expected.end(), expected.begin(), expected.end());
+    std::stable_sort(expected.begin(), expected.end());
+
+    REQUIRE_FALSE(probe.overlapped);
+    REQUIRE(probe.order == expected);
+}
+
+// Tasks which record thread they were updated on.
+class UndeclaredThreadTask : public Task<UndeclaredThreadTask> {
+   public:
+    UndeclaredThreadTask(ECS& engine) : Task(engine) { frequency = std::chrono::milliseconds(1); }
+
+    void update() { thread = std::this_thread::get_id(); }
+
+    std::thread::id thread;
+};
+
+class MainThreadReader : public Task<MainThreadReader, Reads<TaskTestPosition>> {
+   public:
+    MainThreadReader(ECS& engine) : Task(engine) {
+        frequency = std::chrono::milliseconds(1);
+        runsOnMainThread = true;
+    }
+
+    void update() { thread = std::this_thread::get_id(); }
+
+    std::thread::id thread;
+};
+
+TEST_CASE("Tasks which need main thread are run on the thread calling update", "[TaskScheduler]") {
+    ECS engine;
+    engine.jobs.start(2);
+    TaskScheduler taskManager(engine);
+    TaskProbe probe;
+
+    taskManager.addTask<PositionReader>(probe);
+    taskManager.addTask<VelocityWriter>(probe);
+    auto undeclared = taskManager.addTask<UndeclaredThreadTask>();
+    auto mainThreadReader = taskManager.addTask<MainThreadReader>();
+    REQUIRE(undeclared->needsMainThread());
+    REQUIRE(mainThreadReader->needsMainThread());
+
+    for (auto i = 0; i < 20; i++) {
+        undeclared->thread = mainThreadReader->thread = std::thread::id();
+        taskManager.update(std::chrono::milliseconds(1));
+        REQUIRE(undeclared->thread == std::this_thread::get_id());
+        REQUIRE(mainThreadReader->thread == std::this_thread::get_id());
+    }
+
+    // declared tasks between them still run concurrently
+    REQUIRE(probe.overlapped);
+}
+
+TEST_CASE("Frequencies above 1kHz are kept exactly over a long run", "[TaskScheduler]") {
+    using namespace std::chrono;
+    ECS engine;
+    TaskScheduler taskManager(engine);
+
+    auto inputTask = taskManager.addTask<TestTask>();
+    auto networkTask = taskManager.addTask<OtherTestTask>();
+    inputTask->frequency = microseconds(125);  // 8kHz
+    networkTask->frequency = nanoseconds(seconds(1)) / 3000;
+
+    // about 10 minutes of frames of uneven, non-whole-millisecond lengths
+    nanoseconds total{0};
+    for (auto frame = 0; frame < 100000; frame++) {
+        auto elapsed = nanoseconds(5000000 + (frame * 7919) % 2000000);
+        taskManager.update(elapsed);
+        total += elapsed;
+    }
+
+    REQUIRE(total > minutes(9));
+    REQUIRE(inputTask->updateCounter == (size_t)(total / inputTask->frequency));
+    REQUIRE(networkTask->updateCounter == (size_t)(total / networkTask->frequency));
+    REQUIRE(inputTask->accumulatedTime == total % inputTask->frequency);
+}
+
+TEST_CASE("240Hz task doesn't drift when fed with frames of its length", "[TaskScheduler]") {
+    using namespace std::chrono;
+    ECS engine;
+    TaskScheduler taskManager(engine);
+
+    auto task = taskManager.addTask<TestTask>();
+    task->frequency = nanoseconds(seconds(1)) / 240;
+
+    // an hour of frames, measured with jitter around the period
+    const size_t frames = 240 * 3600;
+    for (auto frame = 0u; frame < frames; frame++) {
+        auto jitter = nanoseconds(frame % 2 ? 3000 : -3000);
+        taskManager.update(task->frequency + jitter);
+    }
+
+    REQUIRE(task->updateCounter == frames);
+    REQUIRE(task->accumulatedTime == nanoseconds(0));
+
+    // time accumulated during a stall is capped at a second
+    taskManager.update(seconds(10));
+    REQUIRE(task->updateCounter == frames + 240);
+}
+
+TEST_CASE("Catch-up policies limit updates after a stall", "[TaskScheduler]") {
+    using namespace std::chrono;
+
+    auto stall = [](TaskBase::CatchUp policy, TaskScheduler& taskManager) {
+        auto task = taskManager.addTask<TestTask>();
+        task->frequency = milliseconds(10);
+        task->catchUp = policy;
+        task->maxCatchUpSteps = 4;
+        taskManager.update(milliseconds(105));
+        return task;
+    };
+
+    ECS engine;
+    SECTION("Unlimited") {
+        TaskScheduler taskManager(engine);
+        auto task = stall(TaskBase::CatchUp::Unlimited, taskManager);
+        REQUIRE(task->updateCounter == 10);
+        REQUIRE(task->droppedTime == nanoseconds(0));
+
+        // time above backlog limit is dropped anyway
+        taskManager.update(seconds(3));
+        REQUIRE(task->updateCounter == 110);
+        REQUIRE(task->droppedTime == milliseconds(2005));
+        REQUIRE(taskManager.getStatistics().droppedTime == milliseconds(2005));
+    }
+
+    SECTION("MaxSteps") {
+        TaskScheduler taskManager(engine);
+        auto task = stall(TaskBase::CatchUp::MaxSteps, taskManager);
+        REQUIRE(task->updateCounter == 4);
+        REQUIRE(task->accumulatedTime == milliseconds(65));
+
+        // remaining periods are caught up in following calls, and nothing is lost
+        REQUIRE(taskManager.update(milliseconds(0)) < nanoseconds(0));
+        taskManager.update(milliseconds(0));
+        REQUIRE(task->updateCounter == 10);
+        REQUIRE(task->accumulatedTime == milliseconds(5));
+        REQUIRE(task->droppedTime == nanoseconds(0));
+    }
+
+    SECTION("DropTime") {
+        TaskScheduler taskManager(engine);
+        auto task = stall(TaskBase::CatchUp::DropTime, taskManager);
+        REQUIRE(task->updateCounter == 4);
+        REQUIRE(task->accumulatedTime == milliseconds(5));
+        REQUIRE(task->droppedTime == milliseconds(60));
+        REQUIRE(taskManager.getStatistics().droppedTime == milliseconds(60));
+    }
+
+    SECTION("StretchTime") {
+        TaskScheduler taskManager(engine);
+        auto task = stall(TaskBase::CatchUp::StretchTime, taskManager);
+        REQUIRE(task->updateCounter == 4);
+        REQUIRE(task->stepTime == milliseconds(25));
+        REQUIRE(task->accumulatedTime == milliseconds(5));
+        REQUIRE(task->droppedTime == nanoseconds(0));
+
+        taskManager.update(milliseconds(5));
+        REQUIRE(task->updateCounter == 5);
+        REQUIRE(task->stepTime == milliseconds(10));
+    }
+}
+
+class SlowTestTask : public Task<SlowTestTask> {
+   public:
+    SlowTestTask(ECS& engine) : Task(engine) {}
+
+    void update() {
+        auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(2);
+        while (std::chrono::steady_clock::now() < end) {
+        }
+        updateCounter++;
+    };
+
+    size_t updateCounter = 0;
+};
+
+TEST_CASE("Tasks with low priority are deferred when frame budget is exceeded", "[TaskScheduler]") {
+    using namespace std::chrono;
+    ECS engine;
+    TaskScheduler taskManager(engine);
+    taskManager.setFrameBudget(milliseconds(1));
+
+    auto slowTask = taskManager.addTask<SlowTestTask>();
+    auto importantTask = taskManager.addTask<TestTask>();
+    slowTask->frequency = milliseconds(10);
+    importantTask->frequency = milliseconds(10);
+    importantTask->priority = 1;
+
+    // cost of slow task is unknown until it runs once
+    taskManager.update(milliseconds(10));
+    REQUIRE(slowTask->updateCounter == 1);
+    REQUIRE(importantTask->updateCounter == 1);
+    REQUIRE(taskManager.getStatistics().overBudgetFrames == 1);
+
+    // deferred time is due already, so next update isn't postponed by the frequency
+    REQUIRE(taskManager.update(milliseconds(10)) <= nanoseconds(0));
+    REQUIRE(slowTask->updateCounter == 1);
+    REQUIRE(importantTask->updateCounter == 2);
+    REQUIRE(slowTask->deferrals == 1);
+    REQUIRE(slowTask->accumulatedTime == milliseconds(10));
+
+    // with DropTime policy deferred time is shed instead
+    slowTask->catchUp = TaskBase::CatchUp::DropTime;
+    taskManager.update(milliseconds(10));
+    REQUIRE(slowTask->updateCounter == 1);
+    REQUIRE(slowTask->droppedTime == milliseconds(20));
+    REQUIRE(slowTask->accumulatedTime == nanoseconds(0));
+    REQUIRE(taskManager.getStatistics().deferrals == 2);
+
+    // task deferred too many times in a row runs anyway
+    slowTask->maxDeferrals = 2;
+    taskManager.update(milliseconds(10));
+    REQUIRE(slowTask->updateCounter == 2);
+    REQUIRE(slowTask->deferredInRow == 0);
+    taskManager.update(milliseconds(10));
+    REQUIRE(slowTask->updateCounter == 2);
+    REQUIRE(slowTask->deferredInRow == 1);
+
+    // without budget, every due task runs
+    taskManager.setFrameBudget(nanoseconds(0));
+    taskManager.update(milliseconds(10));
+    REQUIRE(slowTask->updateCounter == 3);
+
+    taskManager.resetStatistics();
+    REQUIRE(taskManager.getStatistics().deferrals == 0);
+}
+
+struct InventoryChanged : Event<InventoryChanged> {};
+struct InventoryCleared : Event<InventoryCleared> {};
+
+class InventorySaver : public Task<InventorySaver>, TriggeredBy<InventoryChanged, InventoryCleared> {
+   public:
+    InventorySaver(ECS& engine) : Task(engine), TriggeredBy(this) {}
+
+    void update() {
+        updateCounter++;
+        if (stopEngine) {
+            ecs.stop();
+        }
+    };
+
+    size_t updateCounter = 0;
+    bool stopEngine = false;
+};
+
+TEST_CASE("Event driven tasks are updated only after their events were emitted", "[TaskScheduler]") {
+    using namespace std::chrono;
+    ECS engine;
+    auto saver = engine.tasks.addTask<InventorySaver>();
+
+    // task without trigger doesn't need to be polled
+    REQUIRE(engine.tasks.update(seconds(1)) == nanoseconds::max());
+    REQUIRE(saver->updateCounter == 0);
+
+    engine.events.emplace<InventoryChanged>();
+    engine.events.emplace<InventoryChanged>();
+    engine.events.emplace<InventoryCleared>();
+    REQUIRE_FALSE(engine.tasks.hasTriggeredTasks());
+    engine.events.emit();
+    REQUIRE(engine.tasks.hasTriggeredTasks());
+
+    // any number of triggering events results in single update, covering time since the previous one
+    engine.tasks.update(milliseconds(5));
+    REQUIRE(saver->updateCounter == 1);
+    REQUIRE(saver->stepTime == milliseconds(1005));
+    REQUIRE_FALSE(engine.tasks.hasTriggeredTasks());
+
+    engine.tasks.update(seconds(1));
+    REQUIRE(saver->updateCounter == 1);
+}
+
+TEST_CASE("Event driven tasks are triggered by stopped and targeted events", "[TaskScheduler]") {
+    using namespace std::chrono;
+    ECS engine;
+    auto saver = engine.tasks.addTask<InventorySaver>();
+
+    // receiver of higher priority stops the event before any other receiver gets it
+    auto stopper = engine.events.connect<InventoryChanged>([](InventoryChanged&) { return false; }, -10);
+    engine.events.emplace<InventoryChanged>();
+    engine.events.emit();
+    REQUIRE(engine.tasks.hasTriggeredTasks());
+    engine.tasks.update(milliseconds(1));
+    REQUIRE(saver->updateCounter == 1);
+    engine.events.disconnect(stopper);
+
+    // events targeted at an entity trigger the task even if nobody is subscribed to it
+    engine.events.pushTo<InventoryCleared>(EntityID(5));
+    engine.events.emit();
+    REQUIRE(engine.tasks.hasTriggeredTasks());
+    engine.tasks.update(milliseconds(1));
+    REQUIRE(saver->updateCounter == 2);
+}
+
+TEST_CASE("Main loop sleeps until event driven task is triggered", "[TaskScheduler]") {
+    using namespace std::chrono;
+    ECS engine;
+    auto saver = engine.tasks.addTask<InventorySaver>();
+    saver->stopEngine = true;
+
+    // event pushed from another thread wakes the loop up well before its one second cap
+    auto start = steady_clock::now();
+    std::thread producer([&engine]() {
+        std::this_thread::sleep_for(milliseconds(50));
+        engine.events.emplace<InventoryChanged>();
+    });
+    engine.run();
+    producer.join();
+
+    REQUIRE(saver->updateCounter == 1);
+    auto ran = steady_clock::now() - start;
+    REQUIRE(ran < milliseconds(500));
+    REQUIRE(engine.pacer.getWakeups() >= 1);
+}
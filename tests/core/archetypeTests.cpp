@@ -0,0 +1,200 @@
+#include <catch.hpp>
+#include <string>
+#include "ecs/ecs.h"
+using namespace EECS;
+
+struct ArchPosition : public Component<ArchPosition> {
+    using Storage = ArchetypeStorage;
+
+    ArchPosition(int x = 0, int y = 0) : x(x), y(y) {}
+
+    int x, y;
+};
+
+struct ArchVelocity : public Component<ArchVelocity> {
+    using Storage = ArchetypeStorage;
+
+    ArchVelocity(int dx = 0) : dx(dx) {}
+
+    int dx;
+};
+
+struct ArchName : public Component<ArchName> {
+    using Storage = ArchetypeStorage;
+
+    ArchName(std::string name = "") : name(std::move(name)) { alive++; }
+    ArchName(const ArchName& other) : name(other.name) { alive++; }
+    ArchName(ArchName&& other) : name(std::move(other.name)) { alive++; }
+    ArchName& operator=(const ArchName&) = default;
+    ArchName& operator=(ArchName&&) = default;
+    ~ArchName() { alive--; }
+
+    std::string name;
+    static int alive;
+};
+
+int ArchName::alive = 0;
+
+TEST_CASE("Archetype storage: adding, getting, replacing and deleting components", "[Archetype]") {
+    ComponentManager comps;
+
+    REQUIRE(comps.addComponent<ArchPosition>(1, 1, 2));
+    REQUIRE(comps.addComponent<ArchVelocity>(1, 3));
+    REQUIRE(comps.addComponent<ArchPosition>(2, 20, 21));
+
+    // entity 1 moved to {Position, Velocity} archetype, its position survived the move
+    REQUIRE(comps.getComponent<ArchPosition>(1)->x == 1);
+    REQUIRE(comps.getComponent<ArchPosition>(1)->y == 2);
+    REQUIRE(comps.getComponent<ArchVelocity>(1)->dx == 3);
+    REQUIRE(comps.getComponent<ArchPosition>(1)->entityID == 1);
+    REQUIRE(comps.getComponent<ArchVelocity>(2) == nullptr);
+    REQUIRE(comps.getComponent<ArchPosition>(3) == nullptr);
+
+    // replacing doesn't move the entity
+    comps.addComponent<ArchVelocity>(1, 4);
+    REQUIRE(comps.getComponent<ArchVelocity>(1)->dx == 4);
+
+    REQUIRE(comps.deleteComponent<ArchPosition>(1));
+    REQUIRE_FALSE(comps.deleteComponent<ArchPosition>(1));
+    REQUIRE(comps.getComponent<ArchPosition>(1) == nullptr);
+    REQUIRE(comps.getComponent<ArchVelocity>(1)->dx == 4);
+    REQUIRE(comps.getComponent<ArchPosition>(2)->x == 20);
+
+    REQUIRE(comps.deleteComponent<ArchVelocity>(1));
+    REQUIRE(comps.getComponent<ArchVelocity>(1) == nullptr);
+}
+
+TEST_CASE("Archetype storage: many entities spanning several chunks", "[Archetype]") {
+    ComponentManager comps;
+    const int count = 10000;
+
+    for (auto i = 1; i <= count; i++) {
+        comps.addComponent<ArchPosition>(i, i, -i);
+        if (i % 2 == 0) {
+            comps.addComponent<ArchVelocity>(i, i);
+        }
+    }
+
+    // delete some entities from the middle of archetypes; remaining rows must still be found
+    for (auto i = 1; i <= count; i += 7) {
+        comps.deleteComponent<ArchPosition>(i);
+    }
+
+    for (auto i = 1; i <= count; i++) {
+        auto position = comps.getComponent<ArchPosition>(i);
+        if ((i - 1) % 7 == 0) {
+            REQUIRE(position == nullptr);
+        } else {
+            REQUIRE(position != nullptr);
+            REQUIRE(position->x == i);
+        }
+    }
+
+    auto moving = 0;
+    for (auto components : comps.view<ArchPosition, ArchVelocity>()) {
+        auto& position = std::get<ArchPosition&>(components);
+        auto& velocity = std::get<ArchVelocity&>(components);
+        REQUIRE(position.entityID == velocity.entityID);
+        position.x += velocity.dx;
+        moving++;
+    }
+
+    auto expected = 0;
+    for (auto i = 2; i <= count; i += 2) {
+        if ((i - 1) % 7 != 0) {
+            expected++;
+            REQUIRE(comps.getComponent<ArchPosition>(i)->x == 2 * i);
+        }
+    }
+    REQUIRE(moving == expected);
+
+    auto intersection = comps.intersection<ArchVelocity, ArchPosition>();
+    REQUIRE(intersection.size() == (size_t)expected);
+    for (auto& components : intersection) {
+        REQUIRE(components.get<ArchPosition>().entityID == components.entity());
+    }
+
+    size_t chunked = 0;
+    comps.view<ArchPosition>().forEachChunk([&](size_t rows, EntityID* entities, ArchPosition* positions) {
+        for (auto i = 0u; i < rows; i++) {
+            REQUIRE(positions[i].entityID == entities[i]);
+        }
+        chunked += rows;
+    });
+    REQUIRE(chunked == comps.intersection<ArchPosition>().size());
+}
+
+TEST_CASE("Archetype storage: components are relocated and destroyed properly", "[Archetype]") {
+    ArchName::alive = 0;
+
+    {
+        ComponentManager comps;
+        EntityManager entities(comps);
+        comps.setEntityManager(entities);
+
+        auto first = entities.addEntity();
+        auto second = entities.addEntity();
+        first.addComponent<ArchName>("first entity with quite a long name");
+        second.addComponent<ArchName>("second");
+        second.addComponent<ArchPosition>(5, 5);
+        first.addComponent<ArchPosition>(1, 1);
+        REQUIRE(ArchName::alive == 2);
+
+        REQUIRE(first.component<ArchName>()->name == "first entity with quite a long name");
+        REQUIRE(second.component<ArchName>()->name == "second");
+
+        auto clone = first.clone();
+        REQUIRE(clone.component<ArchName>()->name == "first entity with quite a long name");
+        REQUIRE(clone.component<ArchPosition>()->x == 1);
+        REQUIRE(ArchName::alive == 3);
+
+        first.destroy();
+        REQUIRE(ArchName::alive == 2);
+        REQUIRE(second.component<ArchName>()->name == "second");
+
+        comps.clear<ArchName>();
+        REQUIRE(ArchName::alive == 0);
+        REQUIRE(second.component<ArchPosition>()->x == 5);
+
+        clone.addComponent<ArchName>("again");
+    }
+
+    // store destroyed components left in it
+    REQUIRE(ArchName::alive == 0);
+}
+
+TEST_CASE("Archetype storage: handles and pointer validity", "[Archetype]") {
+    ComponentManager comps;
+
+    auto handle = comps.addComponent<ArchPosition>(1, 7, 7);
+    auto pointer = comps.getComponent<ArchPosition>(1);
+    REQUIRE(comps.validComponentPointer(pointer, 1));
+
+    // adding other archetype-stored component moves entity to other archetype
+    comps.addComponent<ArchVelocity>(1);
+    REQUIRE_FALSE(comps.validComponentPointer(pointer, 1));
+    REQUIRE(handle->x == 7);
+
+    comps.deleteComponent<ArchPosition>(1);
+    REQUIRE_FALSE(handle);
+}
+
+TEST_CASE("Archetype storage: views don't modify the store", "[Archetype]") {
+    ArchetypeStore store;
+
+    // type never registered matches nothing, and stays unregistered
+    ArchetypeView<ArchPosition> unregistered(store);
+    REQUIRE(unregistered.begin() == unregistered.end());
+    REQUIRE(store.typeID<ArchPosition>() == ArchetypeStore::noType);
+
+    store.add<ArchPosition>(1, 5, 6);
+    REQUIRE(store.typeID<ArchPosition>() == ComponentContainerID::get<ArchPosition>());
+    ArchetypeView<ArchPosition> registered(store);
+    REQUIRE(std::get<0>(*registered.begin()).x == 5);
+    REQUIRE(store.typeID<ArchVelocity>() == ArchetypeStore::noType);
+
+    // ComponentManager registers archetype-stored types when it creates their containers
+    ComponentManager comps;
+    auto view = comps.view<ArchPosition, ArchVelocity>();
+    REQUIRE(view.begin() == view.end());
+}
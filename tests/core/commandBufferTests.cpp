@@ -0,0 +1,120 @@
+#include <catch.hpp>
+#include <atomic>
+#include "ecs/ecs.h"
+using namespace EECS;
+
+struct CommandTestComponent : public Component<CommandTestComponent> {
+    CommandTestComponent(int value = 0) : value(value) {}
+
+    int value;
+};
+
+struct OtherCommandTestComponent : public Component<OtherCommandTestComponent> {
+    using Storage = SparseSetStorage;
+
+    OtherCommandTestComponent(int value = 0) : value(value) {}
+
+    int value;
+};
+
+TEST_CASE("Command buffer makes recorded changes only on playback", "[CommandBuffer]") {
+    ComponentManager comps;
+    EntityManager entities(comps);
+    comps.setEntityManager(entities);
+
+    auto first = entities.addEntity();
+    auto second = entities.addEntity();
+    comps.addComponent<CommandTestComponent>(first, 1);
+    comps.addComponent<OtherCommandTestComponent>(first, 1);
+
+    CommandBuffer commands;
+    commands.addComponent<CommandTestComponent>(second, 2);
+    commands.addComponent<CommandTestComponent>(second, 3);
+    commands.deleteComponent<OtherCommandTestComponent>(first);
+    commands.deleteEntity(first);
+
+    auto created = commands.createEntity();
+    commands.addComponent<CommandTestComponent>(created, 4);
+    commands.addComponent<OtherCommandTestComponent>(created, 5);
+
+    REQUIRE_FALSE(commands.empty());
+    REQUIRE(comps.getComponent<CommandTestComponent>(second) == nullptr);
+    REQUIRE(comps.getComponent<OtherCommandTestComponent>(first) != nullptr);
+    REQUIRE(entities.entityExists(first));
+
+    commands.playback(entities, comps);
+    REQUIRE(commands.empty());
+
+    REQUIRE_FALSE(entities.entityExists(first));
+    REQUIRE(comps.getComponent<CommandTestComponent>(second)->value == 3);  // the last addition wins
+
+    auto& all = comps.getAllComponents<CommandTestComponent>();
+    REQUIRE(all.size() == 2);
+    auto createdID = all.back().entityID;
+    REQUIRE(entities.entityExists(createdID));
+    REQUIRE(all.back().value == 4);
+    REQUIRE(comps.getComponent<OtherCommandTestComponent>(createdID)->value == 5);
+
+    // deletion wins over addition, regardless of recording order
+    commands.deleteComponent<CommandTestComponent>(second);
+    commands.addComponent<CommandTestComponent>(second, 6);
+    commands.playback(entities, comps);
+    REQUIRE(comps.getComponent<CommandTestComponent>(second) == nullptr);
+}
+
+TEST_CASE("Command buffers recorded on many threads are played back together", "[CommandBuffer]") {
+    ECS engine;
+    engine.jobs.start(4);
+    const size_t count = 10000;
+
+    std::vector<EntityID> existing;
+    for (auto i = 0u; i < count; i++) {
+        existing.push_back(engine.entities.addEntity().getID());
+    }
+
+    engine.jobs.parallelFor(0, count, 100, [&](size_t begin, size_t end) {
+        auto& commands = engine.commands.local();
+        for (auto i = begin; i < end; i++) {
+            commands.addComponent<CommandTestComponent>(existing[i], (int)i);
+            auto created = commands.createEntity();
+            commands.addComponent<OtherCommandTestComponent>(created, (int)i);
+        }
+    });
+
+    REQUIRE(engine.components.getAllComponents<CommandTestComponent>().empty());
+    engine.commands.playback();
+
+    auto& components = engine.components.getAllComponents<CommandTestComponent>();
+    REQUIRE(components.size() == count);
+    for (auto i = 0u; i < count; i++) {
+        REQUIRE(engine.components.getComponent<CommandTestComponent>(existing[i])->value == (int)i);
+    }
+
+    auto& created = engine.components.getAllComponents<OtherCommandTestComponent>();
+    REQUIRE(created.size() == count);
+    for (const auto& component : created) {
+        REQUIRE(engine.entities.entityExists(component.entityID));
+    }
+
+    // buffers are empty after playback
+    engine.commands.playback();
+    REQUIRE(engine.components.getAllComponents<OtherCommandTestComponent>().size() == count);
+}
+
+class SpawningTask : public Task<SpawningTask, Reads<>> {
+   public:
+    SpawningTask(ECS& engine) : Task(engine) { frequency = std::chrono::milliseconds(1); }
+
+    void update() {
+        auto& commands = ecs.commands.local();
+        commands.addComponent<CommandTestComponent>(commands.createEntity(), 42);
+    }
+};
+
+TEST_CASE("Commands recorded by tasks are played back after TaskScheduler update", "[CommandBuffer]") {
+    ECS engine;
+    engine.tasks.addTask<SpawningTask>();
+
+    engine.tasks.update(std::chrono::milliseconds(3));
+    REQUIRE(engine.components.getAllComponents<CommandTestComponent>().size() == 3);
+}
@@ -8,6 +8,14 @@ struct AComponent : public Component<AComponent> {
     int foo = 0;
 };
 
+struct ASparseComponent : public Component<ASparseComponent> {
+    using Storage = SparseSetStorage;
+
+    ASparseComponent(int init = 0) : foo(init) {}
+
+    int foo = 0;
+};
+
 TEST_CASE("Adding component to null entity is impossible and yields nullptr") {
     ComponentContainer<AComponent> comps;
     auto componentPtr = comps.addComponent(0);
@@ -120,3 +128,67 @@ TEST_CASE("Getting new class instance works") {
     REQUIRE(newContainer.get() != nullptr);
     REQUIRE(newContainer.get() != &originalContainer);
 }
+
+TEST_CASE("Sparse set container: adding, getting and replacing components") {
+    ComponentContainer<ASparseComponent> comps;
+
+    REQUIRE(comps.addComponent(0) == nullptr);
+    REQUIRE(comps.getComponent(1) == nullptr);
+
+    comps.addComponent(5, 5);
+    comps.addComponent(1, 1);
+    comps.addComponent(100000, 100000);  // on the other page of the sparse table
+
+    REQUIRE(comps.getComponent(5)->foo == 5);
+    REQUIRE(comps.getComponent(1)->foo == 1);
+    REQUIRE(comps.getComponent(100000)->foo == 100000);
+    REQUIRE(comps.getComponent(2) == nullptr);
+
+    // existing component is replaced, not duplicated
+    comps.addComponent(5, 55);
+    REQUIRE(comps.getComponent(5)->foo == 55);
+    REQUIRE(comps.getAllComponents().size() == 3);
+}
+
+TEST_CASE("Sparse set container: deletion keeps the remaining components contiguous and reachable") {
+    ComponentContainer<ASparseComponent> comps;
+
+    for (auto i = 1; i <= 10; i++) {
+        comps.addComponent(i, i);
+    }
+
+    REQUIRE(comps.deleteComponent(1));
+    REQUIRE(comps.genericDeleteComponent(10));
+    REQUIRE(comps.deleteComponent(5));
+    REQUIRE_FALSE(comps.deleteComponent(5));
+
+    REQUIRE(comps.getAllComponents().size() == 7);
+    for (auto i = 1; i <= 10; i++) {
+        if (i == 1 || i == 5 || i == 10) {
+            REQUIRE(comps.getComponent(i) == nullptr);
+        } else {
+            REQUIRE(comps.getComponent(i) != nullptr);
+            REQUIRE(comps.getComponent(i)->foo == i);
+        }
+    }
+
+    // each element of the dense vector is a live component
+    for (auto& component : comps.getAllComponents()) {
+        REQUIRE(comps.getComponent(component.entityID) == &component);
+    }
+}
+
+TEST_CASE("Sparse set container: cloning and clearing") {
+    ComponentContainer<ASparseComponent> comps;
+
+    comps.addComponent(1, 42);
+    REQUIRE(comps.cloneComponent(1, 2));
+    REQUIRE_FALSE(comps.cloneComponent(3, 4));
+    REQUIRE(comps.getComponent(2)->foo == 42);
+    REQUIRE(comps.getComponent(2)->entityID == 2);
+
+    comps.clear();
+    REQUIRE(comps.getComponent(1) == nullptr);
+    REQUIRE(comps.getComponent(2) == nullptr);
+    REQUIRE(comps.getAllComponents().empty());
+}
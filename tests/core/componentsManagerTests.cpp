@@ -14,6 +14,14 @@ struct BarComponent : public Component<BarComponent> {
     int bar = 0;
 };
 
+struct BazComponent : public Component<BazComponent> {
+    using Storage = SparseSetStorage;
+
+    explicit BazComponent(int p = 0) : baz(p) {}
+
+    int baz = 0;
+};
+
 TEST_CASE("Basic methods test") {
     ComponentManager comps;
 
@@ -125,6 +133,267 @@ TEST_CASE("Intersection method test - multithreading") {
     REQUIRE(intersection.size() == 100);
 }
 
+TEST_CASE("Intersection method test - job system") {
+    JobSystem jobs(3);
+    ComponentManager comps;
+    comps.setJobSystem(jobs);
+
+    for (auto i = 1; i <= 10000; i++) {
+        comps.addComponent<FooComponent>(i, i);
+        if (i % 3 == 0) {
+            comps.addComponent<BarComponent>(i, i);
+        }
+    }
+
+    auto intersection = comps.intersection<FooComponent, BarComponent>();
+    REQUIRE(intersection.size() == 3333);
+
+    // chunks are concatenated in order, and each entity got its own components
+    for (auto i = 0u; i < intersection.size(); i++) {
+        REQUIRE(intersection[i].entity() == (i + 1) * 3);
+        REQUIRE((intersection[i].get<FooComponent>().foo == intersection[i].get<BarComponent>().bar));
+    }
+}
+
+TEST_CASE("Intersection of empty container yields nothing") {
+    ComponentManager comps;
+    comps.addComponent<BarComponent>(1);
+
+    REQUIRE((comps.intersection<FooComponent, BarComponent>().empty()));
+}
+
+TEST_CASE("Intersection driven by the smallest container, with skewed sizes") {
+    JobSystem jobs(2);
+    ComponentManager comps;
+    comps.setJobSystem(jobs);
+
+    // Foo is dense, Bar is sparse, both sorted containers - merge join should gallop through Foo
+    for (auto i = 1; i <= 50000; i++) {
+        comps.addComponent<FooComponent>(i, i);
+        if (i % 20 == 0) {
+            comps.addComponent<BarComponent>(i, -i);
+        }
+    }
+    comps.addComponent<BarComponent>(60000);  // past the last Foo
+
+    auto both = comps.intersection<FooComponent, BarComponent>();
+    REQUIRE(both.size() == 2500);
+    for (auto i = 0u; i < both.size(); i++) {
+        REQUIRE(both[i].entity() == (i + 1) * 20);
+        REQUIRE((both[i].get<FooComponent>().foo == -both[i].get<BarComponent>().bar));
+    }
+
+    // result doesn't depend on order of types
+    auto reversed = comps.intersection<BarComponent, FooComponent>();
+    REQUIRE(reversed.size() == 2500);
+}
+
+TEST_CASE("Intersection of sorted and sparse set containers") {
+    ComponentManager comps;
+
+    for (auto i = 1; i <= 100; i++) {
+        comps.addComponent<FooComponent>(i, i);
+        comps.addComponent<BarComponent>(i, i);
+    }
+    for (auto i = 100; i >= 1; i -= 3) {
+        comps.addComponent<BazComponent>(i, i);
+    }
+
+    auto all = comps.intersection<FooComponent, BarComponent, BazComponent>();
+    REQUIRE(all.size() == 34);
+    for (auto& components : all) {
+        REQUIRE(((components.entity() - 1) % 3 == 0));
+        REQUIRE((components.get<FooComponent>().foo == components.get<BazComponent>().baz));
+        REQUIRE(components.get<BarComponent>().entityID == components.entity());
+    }
+}
+
+TEST_CASE("View yields components of entities which have all requested types") {
+    ComponentManager comps;
+
+    for (auto i = 1; i <= 10; i++) {
+        comps.addComponent<FooComponent>(i, i);
+        if (i % 2 == 0) {
+            comps.addComponent<BarComponent>(i, i * 10);
+        }
+    }
+    comps.addComponent<BarComponent>(11, 110);
+
+    auto visited = 0;
+    for (auto components : comps.view<FooComponent, BarComponent>()) {
+        auto& foo = std::get<FooComponent&>(components);
+        auto& bar = std::get<BarComponent&>(components);
+
+        REQUIRE(foo.entityID == bar.entityID);
+        REQUIRE((foo.entityID % 2 == 0));
+        REQUIRE(bar.bar == foo.foo * 10);
+
+        bar.bar = -1;
+        visited++;
+    }
+    REQUIRE(visited == 5);
+
+    // components are modified in place
+    REQUIRE(comps.getComponent<BarComponent>(4)->bar == -1);
+    REQUIRE(comps.getComponent<BarComponent>(11)->bar == 110);
+
+    // view of types no entity has all of is empty
+    comps.clear<BarComponent>();
+    auto view = comps.view<FooComponent, BarComponent>();
+    REQUIRE((view.begin() == view.end()));
+}
+
+TEST_CASE("View over sorted and sparse set containers") {
+    ComponentManager comps;
+
+    for (auto i = 1; i <= 30; i++) {
+        comps.addComponent<FooComponent>(i, i);
+    }
+    for (auto i = 30; i >= 1; i -= 2) {
+        comps.addComponent<BazComponent>(i, i);
+    }
+
+    auto visited = 0;
+    for (auto components : comps.view<BazComponent, FooComponent>()) {
+        REQUIRE((std::get<BazComponent&>(components).baz == std::get<FooComponent&>(components).foo));
+        visited++;
+    }
+    REQUIRE(visited == 15);
+}
+
+TEST_CASE("Bulk addition merges new components with existing ones") {
+    ComponentManager comps;
+
+    std::vector<EntityID> oldEntities;
+    for (EntityID i = 2; i <= 1000; i += 2) {
+        oldEntities.push_back(i);
+    }
+    comps.addComponents<FooComponent>(oldEntities, 1);
+    REQUIRE(comps.getAllComponents<FooComponent>().size() == oldEntities.size());
+
+    // unsorted batch, overlapping with existing components, with duplicate and null entity
+    std::vector<EntityID> newEntities = {999, 3, 4, 1001, 3, 0, 1};
+    comps.emplaceBulk<FooComponent>(newEntities,
+                                    [&](size_t i) { return FooComponent((int)newEntities[i] * 10 + (int)i); });
+
+    auto& all = comps.getAllComponents<FooComponent>();
+    REQUIRE(all.size() == oldEntities.size() + 4);
+    REQUIRE(std::is_sorted(all.begin(), all.end(), [](const FooComponent& first, const FooComponent& second) {
+        return first.entityID < second.entityID;
+    }));
+
+    REQUIRE(comps.getComponent<FooComponent>(1)->foo == 16);
+    REQUIRE(comps.getComponent<FooComponent>(3)->foo == 34);  // the last one wins
+    REQUIRE(comps.getComponent<FooComponent>(4)->foo == 42);  // existing component replaced
+    REQUIRE(comps.getComponent<FooComponent>(6)->foo == 1);
+    REQUIRE(comps.getComponent<FooComponent>(999)->foo == 9990);
+    REQUIRE(comps.getComponent<FooComponent>(1001)->entityID == 1001);
+
+    comps.addComponents<BazComponent>(newEntities, 5);
+    REQUIRE(comps.getAllComponents<BazComponent>().size() == 5);
+    REQUIRE(comps.getComponent<BazComponent>(999)->baz == 5);
+}
+
+TEST_CASE("Bulk deletion") {
+    ComponentManager comps;
+
+    std::vector<EntityID> entities;
+    for (EntityID i = 1; i <= 1000; i++) {
+        entities.push_back(i);
+    }
+    comps.addComponents<FooComponent>(entities);
+    comps.addComponents<BazComponent>(entities);
+
+    std::vector<EntityID> deleted = {500, 1, 1000, 2000, 3, 500};
+    REQUIRE(comps.deleteComponents<FooComponent>(deleted) == 4);
+    REQUIRE(comps.deleteComponents<BazComponent>(deleted) == 4);
+
+    REQUIRE(comps.getAllComponents<FooComponent>().size() == 996);
+    REQUIRE(comps.getAllComponents<BazComponent>().size() == 996);
+    for (auto entity : entities) {
+        auto isDeleted = entity == 1 || entity == 3 || entity == 500 || entity == 1000;
+        REQUIRE((comps.getComponent<FooComponent>(entity) == nullptr) == isDeleted);
+        REQUIRE((comps.getComponent<BazComponent>(entity) == nullptr) == isDeleted);
+    }
+}
+
+TEST_CASE("Bulk addition skips nonexistent entities") {
+    ComponentManager comps;
+    EntityManager entityManager(comps);
+    comps.setEntityManager(entityManager);
+
+    auto first = entityManager.addEntity().getID();
+    auto second = entityManager.addEntity().getID();
+    auto deleted = entityManager.addEntity().getID();
+    entityManager.deleteEntity(deleted);
+
+    std::vector<EntityID> entities = {second, deleted, first};
+    comps.emplaceBulk<FooComponent>(entities, [&](size_t i) { return FooComponent((int)i); });
+
+    REQUIRE(comps.getAllComponents<FooComponent>().size() == 2);
+    REQUIRE(comps.getComponent<FooComponent>(first)->foo == 2);
+    REQUIRE(comps.getComponent<FooComponent>(second)->foo == 0);
+}
+
+TEST_CASE("Component signatures follow structural changes") {
+    ComponentManager comps;
+    EntityManager entityManager(comps);
+    comps.setEntityManager(entityManager);
+
+    auto entity = entityManager.addEntity().getID();
+    REQUIRE(comps.getSignature(entity).none());
+    REQUIRE(comps.hasComponents<>(entity));
+
+    comps.addComponent<FooComponent>(entity);
+    comps.addComponent<BazComponent>(entity);
+    REQUIRE((comps.hasComponents<FooComponent, BazComponent>(entity)));
+    REQUIRE_FALSE((comps.hasComponents<FooComponent, BarComponent>(entity)));
+    REQUIRE(comps.getSignature(entity).count() == 2);
+
+    auto clone = entityManager.cloneEntity(entity).getID();
+    REQUIRE((comps.hasComponents<FooComponent, BazComponent>(clone)));
+    REQUIRE(comps.getSignature(clone) == comps.getSignature(entity));
+
+    comps.deleteComponent<FooComponent>(entity);
+    REQUIRE_FALSE(comps.hasComponents<FooComponent>(entity));
+    REQUIRE(comps.hasComponents<BazComponent>(entity));
+
+    std::vector<EntityID> both = {entity, clone};
+    comps.addComponents<BarComponent>(both);
+    REQUIRE(comps.hasComponents<BarComponent>(entity));
+    REQUIRE((comps.hasComponents<BarComponent, FooComponent>(clone)));
+    comps.deleteComponents<BarComponent>(both);
+    REQUIRE_FALSE(comps.hasComponents<BarComponent>(clone));
+
+    comps.clear<BazComponent>();
+    REQUIRE_FALSE(comps.hasComponents<BazComponent>(clone));
+    REQUIRE(comps.hasComponents<FooComponent>(clone));
+
+    // deleting entity visits only containers of its types, and its slot's next occupant starts with no components
+    entityManager.deleteEntity(clone);
+    REQUIRE(comps.getComponent<FooComponent>(clone) == nullptr);
+    REQUIRE(comps.getSignature(clone).none());
+
+    auto reused = entityManager.addEntity().getID();
+    REQUIRE(entityIndex(reused) == entityIndex(clone));
+    REQUIRE(comps.getSignature(reused).none());
+}
+
+TEST_CASE("Component type IDs over the limit of signatures are rejected") {
+    // ID of every registered type fits, as ComponentManager was created
+    ComponentManager comps;
+    REQUIRE(ComponentContainerID::get<FooComponent>() < maxComponentTypes);
+    REQUIRE_NOTHROW(ComponentManager::checkComponentTypeID(maxComponentTypes - 1));
+
+    std::string message;
+    try {
+        ComponentManager::checkComponentTypeID(maxComponentTypes);
+    } catch (const std::length_error& error) {
+        message = error.what();
+    }
+    REQUIRE(message.find("EECS_MAX_COMPONENT_TYPES") != std::string::npos);
+}
+
 TEST_CASE("Component handles test") {
     ComponentManager comps;
 
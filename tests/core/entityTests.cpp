@@ -48,3 +48,35 @@ TEST_CASE("Entity class works") {
     entity.deleteComponent<FooComponent>();
     REQUIRE_FALSE(entity.component<FooComponent>());
 }
+
+TEST_CASE("Entity slots are reused and stale identifiers are detected") {
+    ComponentManager components;
+    EntityManager entities{components};
+    components.setEntityManager(entities);
+
+    auto first = entities.addEntity().getID();
+    auto second = entities.addEntity().getID();
+    REQUIRE(first != second);
+
+    REQUIRE(entities.deleteEntity(first));
+    REQUIRE_FALSE(entities.entityExists(first));
+    REQUIRE_FALSE(entities.deleteEntity(first));
+
+    // slot of deleted entity is reused, but with newer generation
+    auto recycled = entities.addEntity().getID();
+    REQUIRE(entityIndex(recycled) == entityIndex(first));
+    REQUIRE(entityGeneration(recycled) == entityGeneration(first) + 1);
+    REQUIRE(entities.entityExists(recycled));
+    REQUIRE_FALSE(entities.entityExists(first));
+
+    // stale identifier can't be used to modify new entity
+    REQUIRE_FALSE(components.addComponent<FooComponent>(first));
+    REQUIRE(components.addComponent<FooComponent>(recycled, 7));
+    REQUIRE(components.getComponent<FooComponent>(first) == nullptr);
+    REQUIRE(components.getComponent<FooComponent>(recycled)->foo == 7);
+
+    entities.clear();
+    REQUIRE_FALSE(entities.entityExists(recycled));
+    REQUIRE_FALSE(entities.entityExists(second));
+    REQUIRE(components.getComponent<FooComponent>(recycled) == nullptr);
+}
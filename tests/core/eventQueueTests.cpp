@@ -1,4 +1,12 @@
 #include <catch.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <string>
 #include "ecs/ecs.h"
 using namespace EECS;
 
@@ -128,3 +136,691 @@ TEST_CASE("Priority system works") {
     REQUIRE(aReceiver.lastEvent == 6);
     REQUIRE(bReceiver.lastEvent == 3);
 }
+
+struct CountingReceiver : Receives<CountingReceiver, AEvent> {
+    CountingReceiver(EventQueue& ev) : Receives(ev) {}
+
+    bool receive(AEvent& aEvent) {
+        received.push_back(aEvent.x);
+        return true;
+    }
+
+    std::vector<int> received;
+};
+
+TEST_CASE("Events pushed beyond ring capacity are emitted in order of pushing", "[EventQueue]") {
+    EventQueue events;
+    CountingReceiver receiver(events);
+
+    const int count = 5000;
+    for (auto i = 0; i < count; i++) {
+        events.emplace<AEvent>(i);
+    }
+    events.emit();
+
+    REQUIRE(receiver.received.size() == (size_t)count);
+    for (auto i = 0; i < count; i++) {
+        REQUIRE(receiver.received[i] == i);
+    }
+
+    // queue works as usual after the overflow was drained
+    events.push(AEvent(count));
+    events.emit();
+    REQUIRE(receiver.received.back() == count);
+}
+
+TEST_CASE("Events can be pushed from many threads concurrently", "[EventQueue]") {
+    EventQueue events;
+    CountingReceiver receiver(events);
+
+    const int threadCount = 4;
+    const int perThread = 20000;
+    std::atomic<bool> done{false};
+    std::vector<std::thread> producers;
+    for (auto thread = 0; thread < threadCount; thread++) {
+        producers.emplace_back([&events, thread]() {
+            for (auto i = 0; i < perThread; i++) {
+                events.emplace<AEvent>(thread * perThread + i);
+            }
+        });
+    }
+
+    // emit concurrently with pushing, like main loop would
+    std::thread consumer([&]() {
+        while (!done) {
+            events.emit();
+        }
+        events.emit();
+    });
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    done = true;
+    consumer.join();
+
+    REQUIRE(receiver.received.size() == (size_t)(threadCount * perThread));
+
+    // events of each thread were received in order of pushing
+    std::vector<int> lastOfThread(threadCount, -1);
+    for (auto value : receiver.received) {
+        auto thread = value / perThread;
+        REQUIRE(value > lastOfThread[thread]);
+        lastOfThread[thread] = value;
+    }
+}
+
+// pushes next event of the chain, of alternating type, until the chain reaches given length.
+struct ChainReceiver : Receives<ChainReceiver, AEvent, BEvent> {
+    ChainReceiver(EventQueue& ev, int length) : Receives(ev), events(ev), length(length) {}
+
+    bool receive(AEvent& aEvent) {
+        received.push_back(aEvent.x);
+        if (aEvent.x + 1 < length) {
+            events.push(BEvent(aEvent.x + 1));
+        }
+        return true;
+    }
+
+    bool receive(BEvent& bEvent) {
+        received.push_back(bEvent.y);
+        if (bEvent.y + 1 < length) {
+            events.emplace<AEvent>(bEvent.y + 1);
+        }
+        return true;
+    }
+
+    EventQueue& events;
+    int length;
+    std::vector<int> received;
+};
+
+TEST_CASE("Events pushed during emit are delivered in further cascade rounds", "[EventQueue]") {
+    EventQueue events;
+    ChainReceiver receiver(events, 10);
+    events.setMaxCascadeRounds(4);
+
+    events.push(AEvent(0));
+    events.push(AEvent(100));
+    REQUIRE(events.emit() == 4);
+    REQUIRE(receiver.received == (std::vector<int>{0, 100, 1, 2, 3}));
+
+    // rest of the chain waits for the next emit
+    REQUIRE(events.emit() == 4);
+    REQUIRE(receiver.received.back() == 7);
+    REQUIRE(events.emit() == 2);
+    REQUIRE(receiver.received.back() == 9);
+    REQUIRE(events.emit() == 0);
+    REQUIRE(receiver.received.size() == 11);
+}
+
+TEST_CASE("Events left over when cascade rounds ran out are pending", "[EventQueue]") {
+    EventQueue events;
+    ChainReceiver receiver(events, 3);
+    events.setMaxCascadeRounds(1);
+    REQUIRE_FALSE(events.hasPending());
+
+    events.push(AEvent(0));
+    REQUIRE(events.hasPending());
+    REQUIRE(events.emit() == 1);
+    REQUIRE(events.hasPending());
+    REQUIRE(events.emit() == 1);
+    REQUIRE(events.hasPending());
+
+    // the last allowed round delivered the end of the chain
+    REQUIRE(events.emit() == 1);
+    REQUIRE(receiver.received.size() == 3);
+    REQUIRE_FALSE(events.hasPending());
+
+    events.setOrdered(true);
+    events.push(AEvent(5));
+    REQUIRE(events.hasPending());
+    REQUIRE(events.emit() == 1);
+    REQUIRE_FALSE(events.hasPending());
+}
+
+TEST_CASE("Only events pushed outside of emit notify wake signal", "[EventQueue]") {
+    EventQueue events;
+    WakeSignal signal;
+    events.setWakeSignal(&signal);
+    ChainReceiver receiver(events, 3);
+
+    events.push(AEvent(0));
+    REQUIRE(signal.poll());
+
+    // events pushed by receiver are delivered by the same emit
+    REQUIRE(events.emit() == 3);
+    REQUIRE(receiver.received.size() == 3);
+    REQUIRE_FALSE(signal.poll());
+
+    std::thread producer([&events]() { events.push(AEvent(10)); });
+    producer.join();
+    REQUIRE(signal.poll());
+}
+
+struct BatchReceiver {
+    void receiveBatch(Span<AEvent> events) {
+        batches++;
+        for (auto& event : events) {
+            received.push_back(event.x);
+        }
+    }
+
+    int batches = 0;
+    std::vector<int> received;
+};
+
+// stops propagation of odd events
+struct OddFilter {
+    bool receive(AEvent& event) { return event.x % 2 == 0; }
+};
+
+TEST_CASE("Batch receivers get all events which weren't stopped in a single call", "[EventQueue]") {
+    EventQueue events;
+    BatchReceiver first, last;
+    OddFilter filter;
+    CountingReceiver single(events);  // priority 0
+
+    events.connect<AEvent>(first, -1);
+    events.connect<AEvent>(filter, 1);
+    events.connect<AEvent>(last, 2);
+    events.connect<AEvent>(last, 2);  // connecting twice has no effect
+
+    for (auto i = 0; i < 10; i++) {
+        events.emplace<AEvent>(i);
+    }
+    events.emit();
+
+    REQUIRE(first.batches == 1);
+    REQUIRE(first.received == (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+    REQUIRE(single.received == first.received);
+    REQUIRE(last.batches == 1);
+    REQUIRE(last.received == (std::vector<int>{0, 2, 4, 6, 8}));
+
+    // batch receiver isn't called if all events were stopped
+    events.disconnect<AEvent>(first);
+    events.emplace<AEvent>(11);
+    events.emit();
+    REQUIRE(first.batches == 1);
+    REQUIRE(last.batches == 1);
+    REQUIRE(single.received.back() == 11);
+}
+
+// logs received events into shared vector, multiplied by sign.
+struct LoggingReceiver {
+    LoggingReceiver(std::vector<int>& log, int sign) : log(log), sign(sign) {}
+
+    bool receive(AEvent& event) {
+        log.push_back(sign * event.x);
+        return true;
+    }
+
+    std::vector<int>& log;
+    int sign;
+};
+
+TEST_CASE("Without batch receivers, each event is delivered to all receivers before the next one", "[EventQueue]") {
+    EventQueue events;
+    std::vector<int> log;
+    LoggingReceiver positive(log, 1), negative(log, -1);
+    events.connect<AEvent>(positive, 0);
+    events.connect<AEvent>(negative, 1);
+
+    events.emplace<AEvent>(1);
+    events.emplace<AEvent>(2);
+    events.emit();
+    REQUIRE(log == (std::vector<int>{1, -1, 2, -2}));
+}
+
+// remembers tick at which each event was delivered
+struct TickRecorder {
+    TickRecorder(EventQueue& events) : events(events) { events.connect<AEvent>(*this); }
+
+    bool receive(AEvent& event) {
+        received.emplace_back(event.x, events.currentTick());
+        return true;
+    }
+
+    EventQueue& events;
+    std::vector<std::pair<int, uint64_t>> received;
+};
+
+TEST_CASE("Scheduled events are emitted at their ticks, unless cancelled", "[EventQueue]") {
+    EventQueue events;
+    TickRecorder recorder(events);
+    std::mt19937 random(7);
+
+    // deadlines span all levels of the timing wheel
+    std::vector<TimerID> timers;
+    for (auto i = 0; i < 20000; i++) {
+        auto deadline = (int)(random() % (1 << (4 + i % 17)));
+        timers.push_back(events.emitAt<AEvent>(deadline, deadline));
+    }
+
+    auto cancelled = 0;
+    for (auto i = 0u; i < timers.size(); i += 3) {
+        REQUIRE(events.cancel(timers[i]));
+        REQUIRE_FALSE(events.cancel(timers[i]));
+        cancelled++;
+    }
+    REQUIRE(events.scheduledCount() == timers.size() - cancelled);
+
+    uint64_t previousTick = 0;
+    while (events.scheduledCount() > 0) {
+        events.advanceTicks(1 + random() % 5000);
+        events.emit();
+
+        for (auto& event : recorder.received) {
+            // event due at tick 0 or earlier is pushed on the first tick
+            REQUIRE(std::max<uint64_t>(1, event.first) > previousTick);
+            REQUIRE(std::max<uint64_t>(1, event.first) <= event.second);
+        }
+        REQUIRE(std::is_sorted(recorder.received.begin(), recorder.received.end(), [](auto a, auto b) {
+            return std::max(1, a.first) < std::max(1, b.first);
+        }));
+        previousTick = events.currentTick();
+        recorder.received.clear();
+    }
+
+    REQUIRE_FALSE(events.cancel(timers[1]));  // already emitted
+}
+
+TEST_CASE("Events scheduled after delay are counted from current time, without drift", "[EventQueue]") {
+    using namespace std::chrono;
+    EventQueue events;
+    TickRecorder recorder(events);
+
+    events.emitAfter<AEvent>(milliseconds(2), 1);
+    for (auto i = 0; i < 6; i++) {
+        events.advance(microseconds(300));
+    }
+    events.emit();
+    REQUIRE(recorder.received.empty());
+
+    events.emitAfter<AEvent>(milliseconds(1), 2);  // 1.8ms now, so it's due at 2.8ms, on the 3rd tick
+    events.advance(microseconds(300));
+    events.emit();
+    REQUIRE(recorder.received.size() == 1);
+    REQUIRE(recorder.received[0].second == 2);
+
+    events.advance(microseconds(600));
+    events.emit();
+    REQUIRE(recorder.received.size() == 1);
+    events.advance(microseconds(300));
+    events.emit();
+    REQUIRE(recorder.received.size() == 2);
+    REQUIRE(recorder.received[1].first == 2);
+    REQUIRE(recorder.received[1].second == 3);
+
+    // 10000 advances of 0.1ms add up to exactly 1000 ticks
+    for (auto i = 0; i < 10000; i++) {
+        events.advance(microseconds(100));
+    }
+    REQUIRE(events.currentTick() == 1003);
+}
+
+TEST_CASE("Time until the next scheduled event never overshoots it", "[EventQueue]") {
+    using namespace std::chrono;
+    EventQueue events;
+    TickRecorder recorder(events);
+    REQUIRE(events.untilNextScheduled() == nanoseconds::max());
+
+    events.emitAfter<AEvent>(milliseconds(5), 1);
+    events.emitAfter<AEvent>(seconds(100), 2);
+    events.advance(microseconds(300));
+    REQUIRE(events.untilNextScheduled() == microseconds(4700));
+
+    // distant event lies in upper level of the timing wheel, so only lower bound is known
+    events.advance(microseconds(4700));
+    events.emit();
+    REQUIRE(recorder.received.size() == 1);
+    while (events.scheduledCount() > 0) {
+        auto until = events.untilNextScheduled();
+        REQUIRE(until > nanoseconds(0));
+        REQUIRE(until <= seconds(100) - milliseconds(events.currentTick()));
+        events.advance(until);
+        events.emit();
+    }
+    REQUIRE(recorder.received.size() == 2);
+    REQUIRE(events.currentTick() == 100000);
+}
+
+TEST_CASE("Targeted events reach only receivers subscribed to their entity", "[EventQueue]") {
+    EventQueue events;
+    TickRecorder broadcast(events);
+    std::vector<BatchReceiver> perEntity(100);
+    OddFilter filter;
+
+    for (auto i = 0u; i < perEntity.size(); i++) {
+        events.connect<AEvent>(makeEntityID(i, 1), perEntity[i]);
+    }
+    events.connect<AEvent>(makeEntityID(7, 1), filter, -1);
+
+    events.pushTo<AEvent>(makeEntityID(7, 1), 1);
+    events.pushTo<AEvent>(makeEntityID(7, 1), 2);
+    events.pushTo<AEvent>(makeEntityID(42, 1), 3);
+    events.pushTo<AEvent>(makeEntityID(42, 2), 4);  // other generation, nobody is subscribed
+    events.pushTo<AEvent>(makeEntityID(500, 1), 5);
+    events.emit();
+
+    REQUIRE(broadcast.received.empty());
+    REQUIRE(perEntity[7].received == std::vector<int>{2});
+    REQUIRE(perEntity[42].received == std::vector<int>{3});
+    for (auto i = 0u; i < perEntity.size(); i++) {
+        if (i != 7 && i != 42) {
+            REQUIRE(perEntity[i].received.empty());
+        }
+    }
+
+    events.disconnect<AEvent>(makeEntityID(42, 1), perEntity[42]);
+    events.disconnectAll<AEvent>(makeEntityID(7, 1));
+    events.connect<AEvent>(makeEntityID(99, 2), perEntity[0]);  // replaces subscriptions of previous generation
+    events.pushTo<AEvent>(makeEntityID(7, 1), 6);
+    events.pushTo<AEvent>(makeEntityID(42, 1), 7);
+    events.pushTo<AEvent>(makeEntityID(98, 1), 8);
+    events.pushTo<AEvent>(makeEntityID(99, 1), 9);
+    events.pushTo<AEvent>(makeEntityID(99, 2), 10);
+    events.emit();
+
+    REQUIRE(perEntity[7].received.size() == 1);
+    REQUIRE(perEntity[42].received.size() == 1);
+    REQUIRE(perEntity[98].received == std::vector<int>{8});
+    REQUIRE(perEntity[99].received.empty());
+    REQUIRE(perEntity[0].received == std::vector<int>{10});
+}
+
+// isn't trivially copyable, so it's never recorded, and replayed sessions deliver ones pushed during replay.
+struct NoteEvent : Event<NoteEvent> {
+    NoteEvent(std::string text) : text(std::move(text)) {}
+
+    std::string text;
+};
+
+// pushes AEvent every update and NoteEvent on the last one, stops main loop after given number of updates
+class PushingTask : public Task<PushingTask> {
+   public:
+    PushingTask(ECS& engine, size_t updateLimit) : Task(engine), updateLimit(updateLimit) {}
+
+    void update() {
+        ecs.events.emplace<AEvent>((int)updates * 10);
+        if (++updates == updateLimit) {
+            ecs.events.emplace<NoteEvent>("last frame");
+            ecs.stop();
+        }
+    }
+
+    size_t updateLimit;
+    size_t updates = 0;
+};
+
+TEST_CASE("Recorded session replays the same frames and events", "[EventQueue]") {
+    std::stringstream log;
+
+    ECS recorded;
+    ChainReceiver recordedChain(recorded.events, 95);
+    auto recordedTask = recorded.tasks.addTask<PushingTask>(20);
+    recordedTask->frequency = std::chrono::milliseconds(1);
+    recorded.startRecording(log);
+    recorded.run();
+    recorded.stopRecording();
+
+    ECS replayed;
+    ChainReceiver replayedChain(replayed.events, 95);
+    std::vector<std::string> replayedNotes;
+    replayed.events.connect<NoteEvent>([&replayedNotes](NoteEvent& note) { replayedNotes.push_back(note.text); });
+    auto replayedTask = replayed.tasks.addTask<PushingTask>(recordedTask->updates);
+    replayedTask->frequency = std::chrono::milliseconds(1);
+    auto frames = replayed.replay(log);
+
+    REQUIRE(frames > 0);
+    REQUIRE(replayedTask->updates == recordedTask->updates);
+    REQUIRE_FALSE(recordedChain.received.empty());
+    REQUIRE(replayedChain.received == recordedChain.received);
+
+    // event pushed in the final frame is delivered, like in the recorded session
+    REQUIRE(replayedNotes == std::vector<std::string>{"last frame"});
+
+    // malformed log isn't replayed
+    std::stringstream garbage("not a log");
+    REQUIRE(replayed.replay(garbage) == 0);
+}
+
+TEST_CASE("Event log reader rejects truncated and corrupt records", "[EventQueue]") {
+    std::stringstream log;
+    {
+        EventLogWriter writer(log);
+        int payload = 42;
+        writer.event(1, &payload, sizeof(payload));
+        writer.event(1, &payload, sizeof(payload));
+    }
+
+    auto written = log.str();
+    std::stringstream intact(written);
+    EventLogReader reader(intact);
+    REQUIRE(reader.next());
+    REQUIRE(reader.record().payload.size() == sizeof(int));
+    REQUIRE(reader.next());
+    REQUIRE_FALSE(reader.next());
+
+    // second record loses its last byte
+    std::stringstream truncated(written.substr(0, written.size() - 1));
+    EventLogReader truncatedReader(truncated);
+    REQUIRE(truncatedReader.next());
+    REQUIRE_FALSE(truncatedReader.next());
+
+    // size of the first record is garbage; nothing that big is allocated
+    auto sizeOffset = 8 + 1 + sizeof(uint32_t);
+    written.replace(sizeOffset, sizeof(uint32_t), "\xff\xff\xff\xff");
+    std::stringstream corrupt(written);
+    EventLogReader corruptReader(corrupt);
+    REQUIRE_FALSE(corruptReader.next());
+    REQUIRE(corruptReader.record().payload.capacity() == 0);
+}
+
+TEST_CASE("Callables can be connected, and disconnected through subscriptions", "[EventQueue]") {
+    EventQueue events;
+    std::vector<std::string> calls;
+
+    auto low = events.connect<AEvent>([&calls](AEvent&) { calls.push_back("low"); }, -5);
+    auto high = events.connect<AEvent>([&calls](AEvent& event) {
+        calls.push_back("high");
+        return event.x != 0;  // stops propagation of 0
+    }, 5);
+    auto first = events.connect<AEvent>([&calls](AEvent&) { calls.push_back("first"); });
+    // of equal priority, the later connected goes first
+    auto second = events.connect<AEvent>([&calls](AEvent&) { calls.push_back("second"); });
+    auto last = events.connect<AEvent>([&calls](AEvent&) { calls.push_back("last"); }, 10);
+    REQUIRE(low.eventID == high.eventID);
+
+    events.emplace<AEvent>(0);
+    events.emit();
+    REQUIRE(calls == (std::vector<std::string>{"low", "second", "first", "high"}));
+
+    REQUIRE(events.disconnect(second));
+    REQUIRE_FALSE(events.disconnect(second));
+    REQUIRE_FALSE(events.disconnect(Subscription{}));
+    REQUIRE(events.disconnect(low));
+
+    // freed slot is reused, but old subscription doesn't refer to the new receiver
+    auto reused = events.connect<AEvent>([&calls](AEvent&) { calls.push_back("reused"); }, 7);
+    REQUIRE_FALSE(events.disconnect(low));
+
+    calls.clear();
+    events.emplace<AEvent>(1);
+    events.emit();
+    REQUIRE(calls == (std::vector<std::string>{"first", "high", "reused", "last"}));
+
+    REQUIRE(events.disconnect(first));
+    REQUIRE(events.disconnect(high));
+    REQUIRE(events.disconnect(reused));
+    REQUIRE(events.disconnect(last));
+    calls.clear();
+    events.emplace<AEvent>(2);
+    events.emit();
+    REQUIRE(calls.empty());
+}
+
+TEST_CASE("Receivers connected or disconnected during delivery take effect safely", "[EventQueue]") {
+    EventQueue events;
+    std::vector<int> received;
+    Subscription later, added;
+
+    events.connect<AEvent>([&](AEvent& event) {
+        if (event.x == 0) {
+            events.disconnect(later);
+            added = events.connect<AEvent>([&](AEvent& event) { received.push_back(100 + event.x); }, -1);
+        }
+    }, -2);
+    later = events.connect<AEvent>([&](AEvent& event) { received.push_back(event.x); });
+
+    events.emplace<AEvent>(0);
+    events.emplace<AEvent>(1);
+    events.emit();
+    REQUIRE(received.empty());
+
+    events.emplace<AEvent>(2);
+    events.emit();
+    REQUIRE(received == std::vector<int>{102});
+    REQUIRE(events.disconnect(added));
+}
+
+TEST_CASE("Many short-lived per-entity subscriptions", "[EventQueue]") {
+    EventQueue events;
+    const uint32_t entityCount = 5000;
+    std::vector<int> hits(entityCount, 0);
+    std::vector<Subscription> subscriptions;
+
+    for (auto round = 0; round < 4; round++) {
+        for (auto i = 0u; i < entityCount; i++) {
+            subscriptions.push_back(
+                events.connect<AEvent>(makeEntityID(i, 1), [&hits, i](AEvent&) { hits[i]++; }));
+        }
+
+        // every other one is gone before events arrive
+        for (auto i = 0u; i < subscriptions.size(); i += 2) {
+            REQUIRE(events.disconnect(subscriptions[i]));
+        }
+
+        for (auto i = 0u; i < entityCount; i++) {
+            events.pushTo<AEvent>(makeEntityID(i, 1), (int)i);
+        }
+        events.emit();
+
+        for (auto i = 1u; i < subscriptions.size(); i += 2) {
+            REQUIRE(events.disconnect(subscriptions[i]));
+        }
+        subscriptions.clear();
+    }
+
+    for (auto i = 0u; i < entityCount; i++) {
+        REQUIRE(hits[i] == (i % 2 ? 4 : 0));
+    }
+}
+
+struct NameEvent : Event<NameEvent> {
+    NameEvent(std::string name) : name(std::move(name)) {}
+
+    std::string name;
+};
+
+TEST_CASE("In ordered mode events of all types are delivered in order of pushing", "[EventQueue]") {
+    EventQueue events;
+    events.setOrdered(true);
+    std::vector<std::string> received;
+
+    events.connect<AEvent>([&](AEvent& event) { received.push_back("A" + std::to_string(event.x)); });
+    events.connect<BEvent>([&](BEvent& event) {
+        received.push_back("B" + std::to_string(event.y));
+        if (event.y == 2) {
+            events.emplace<NameEvent>("cascaded");
+        }
+    });
+    events.connect<NameEvent>([&](NameEvent& event) { received.push_back(event.name); });
+    events.connect<AEvent>(makeEntityID(1, 1),
+                           [&](AEvent& event) { received.push_back("T" + std::to_string(event.x)); });
+
+    events.emplace<AEvent>(1);
+    events.emplace<BEvent>(2);
+    events.emplace<AEvent>(3);
+    events.emplace<AEvent>(4);
+    events.pushTo<AEvent>(makeEntityID(1, 1), 5);
+    events.emplace<AEvent>(6);
+    events.emplace<NameEvent>(std::string(100, 'x'));  // doesn't fit into small string buffer
+    events.emitAfter<BEvent>(std::chrono::milliseconds(1), 7);
+    events.advanceTicks(1);
+    REQUIRE(events.emit() == 2);
+
+    REQUIRE(received == (std::vector<std::string>{"A1", "B2", "A3", "A4", "T5", "A6", std::string(100, 'x'), "B7",
+                                                  "cascaded"}));
+
+    // events spanning many arena blocks, and ones left pending, are destroyed properly
+    for (auto i = 0; i < 10000; i++) {
+        events.emplace<NameEvent>(std::string(64, 'a' + i % 26));
+    }
+    received.clear();
+    events.emit();
+    REQUIRE(received.size() == 10000);
+    REQUIRE(received[9999] == std::string(64, 'a' + 9999 % 26));
+
+    events.emplace<NameEvent>(std::string(64, 'z'));
+    events.clear();
+    events.emit();
+    REQUIRE(received.size() == 10000);
+}
+
+struct MovedEvent : Event<MovedEvent> {
+    MovedEvent(EntityID entity, int distance) : entity(entity), distance(distance) {}
+
+    EntityID coalesceKey() const { return entity; }
+    void merge(MovedEvent&& newer) { distance += newer.distance; }
+
+    EntityID entity;
+    int distance;
+};
+
+struct StateEvent : Event<StateEvent> {
+    StateEvent(EntityID entity, int state) : entity(entity), state(state) {}
+
+    EntityID coalesceKey() const { return entity; }
+
+    EntityID entity;
+    int state;
+};
+
+TEST_CASE("Coalescing events with equal keys are delivered once per round", "[EventQueue]") {
+    EventQueue events;
+    std::vector<std::pair<EntityID, int>> moves, states;
+    events.connect<MovedEvent>([&](MovedEvent& event) { moves.emplace_back(event.entity, event.distance); });
+    events.connect<StateEvent>([&](StateEvent& event) {
+        states.emplace_back(event.entity, event.state);
+        if (event.state < 3) {
+            events.emplace<StateEvent>(event.entity, 3);  // next round, so it isn't coalesced with this one
+        }
+    });
+
+    const uint32_t entityCount = 1000;
+    for (auto repeat = 0; repeat < 20; repeat++) {
+        for (auto i = 0u; i < entityCount; i++) {
+            events.emplace<MovedEvent>(makeEntityID(i, 1), 1);
+            events.emplace<StateEvent>(makeEntityID(i, 1), repeat % 3);
+        }
+    }
+    events.emplace<MovedEvent>(makeEntityID(0, 2), 5);  // other generation is other key
+    events.emit();
+
+    REQUIRE(moves.size() == entityCount + 1);
+    for (auto i = 0u; i < entityCount; i++) {
+        // earlier event's place is kept
+        REQUIRE(moves[i] == std::make_pair(makeEntityID(i, 1), 20));
+        REQUIRE(states[i] == std::make_pair(makeEntityID(i, 1), 19 % 3));
+    }
+    REQUIRE(moves.back() == std::make_pair(makeEntityID(0, 2), 5));
+    REQUIRE(states.size() == 2 * entityCount);
+    REQUIRE(states.back() == std::make_pair(makeEntityID(entityCount - 1, 1), 3));
+
+    // next emit starts with empty index
+    moves.clear();
+    events.emplace<MovedEvent>(makeEntityID(0, 1), 7);
+    events.emit();
+    REQUIRE(moves == (std::vector<std::pair<EntityID, int>>{{makeEntityID(0, 1), 7}}));
+}
@@ -0,0 +1,114 @@
+#include <catch.hpp>
+#include <chrono>
+#include <thread>
+#include "ecs/ecs.h"
+using namespace EECS;
+
+TEST_CASE("Jitter histogram buckets durations exponentially", "[FramePacer]") {
+    using namespace std::chrono;
+    JitterHistogram histogram;
+
+    for (auto i = 0; i < 90; i++) {
+        histogram.record(nanoseconds(500));
+    }
+    for (auto i = 0; i < 9; i++) {
+        histogram.record(microseconds(3));  // [2us, 4us)
+    }
+    histogram.record(microseconds(700));  // [512us, 1024us)
+
+    REQUIRE(histogram.count() == 100);
+    REQUIRE(histogram.bucket(0) == 90);
+    REQUIRE(histogram.bucket(2) == 9);
+    REQUIRE(histogram.bucket(10) == 1);
+    REQUIRE(histogram.percentile(0.5) == microseconds(1));
+    REQUIRE(histogram.percentile(0.99) == microseconds(4));
+    REQUIRE(histogram.percentile(1.0) == microseconds(700));
+    REQUIRE(histogram.max() == microseconds(700));
+    REQUIRE(histogram.mean() == nanoseconds((90 * 500 + 9 * 3000 + 700000) / 100));
+    REQUIRE(histogram.toString().find("mean") != std::string::npos);
+
+    histogram.clear();
+    REQUIRE(histogram.count() == 0);
+    REQUIRE(histogram.percentile(0.99) == nanoseconds(0));
+}
+
+TEST_CASE("Frame pacer never wakes up before deadline, in any mode", "[FramePacer]") {
+    using namespace std::chrono;
+    FramePacer pacer;
+    pacer.setSpinThreshold(microseconds(500));
+
+    for (auto mode : {FramePacer::Mode::Sleep, FramePacer::Mode::Hybrid, FramePacer::Mode::Spin}) {
+        pacer.setMode(mode);
+        pacer.resetStatistics();
+
+        auto deadline = FramePacer::Clock::now();
+        for (auto frame = 0; frame < 20; frame++) {
+            deadline += microseconds(700);
+            pacer.waitUntil(deadline);
+            REQUIRE(FramePacer::Clock::now() >= deadline);
+        }
+
+        // frames which started late don't wait and count as overruns
+        auto waits = pacer.getHistogram().count() + pacer.getOverruns();
+        REQUIRE(waits == 20);
+    }
+
+    pacer.waitUntil(FramePacer::Clock::now() - milliseconds(1));
+    REQUIRE(pacer.getOverruns() >= 1);
+
+    REQUIRE(FramePacer::parseMode("hybrid") == FramePacer::Mode::Hybrid);
+    REQUIRE(FramePacer::parseMode("spin") == FramePacer::Mode::Spin);
+    REQUIRE(FramePacer::parseMode("anything else") == FramePacer::Mode::Sleep);
+}
+
+TEST_CASE("Wake signal interrupts frame pacer's wait", "[FramePacer]") {
+    using namespace std::chrono;
+    WakeSignal signal;
+    FramePacer pacer;
+    pacer.setWakeSignal(&signal);
+
+    for (auto mode : {FramePacer::Mode::Sleep, FramePacer::Mode::Hybrid, FramePacer::Mode::Spin}) {
+        pacer.setMode(mode);
+        auto start = FramePacer::Clock::now();
+        std::thread notifier([&signal]() {
+            std::this_thread::sleep_for(milliseconds(5));
+            signal.notify();
+        });
+
+        REQUIRE(pacer.waitUntil(start + seconds(10)));
+        auto waited = FramePacer::Clock::now() - start;
+        REQUIRE(waited < seconds(5));
+        notifier.join();
+    }
+    REQUIRE(pacer.getWakeups() == 3);
+
+    // notification which came before waiting isn't lost, and is consumed by the wait
+    signal.notify();
+    REQUIRE(pacer.waitUntil(FramePacer::Clock::now() + seconds(10)));
+    REQUIRE_FALSE(pacer.waitUntil(FramePacer::Clock::now() + milliseconds(1)));
+    REQUIRE(pacer.getHistogram().count() == 1);
+}
+
+TEST_CASE("Wake signal doesn't make sleeping frame pacer less precise", "[FramePacer]") {
+    using namespace std::chrono;
+    WakeSignal signal;
+    FramePacer pacer;
+    pacer.setMode(FramePacer::Mode::Sleep);
+
+    auto meanLateness = [&pacer]() {
+        pacer.resetStatistics();
+        auto deadline = FramePacer::Clock::now();
+        for (auto frame = 0; frame < 30; frame++) {
+            deadline += milliseconds(3);
+            pacer.waitUntil(deadline);
+        }
+        return pacer.getHistogram().mean();
+    };
+
+    auto withoutSignal = meanLateness();
+    pacer.setWakeSignal(&signal);
+    auto withSignal = meanLateness();
+
+    REQUIRE(pacer.getWakeups() == 0);
+    REQUIRE(withSignal <= withoutSignal * 2 + microseconds(100));
+}
@@ -0,0 +1,56 @@
+#include <catch.hpp>
+#include <numeric>
+#include "ecs/ecs.h"
+using namespace EECS;
+
+TEST_CASE("parallelFor visits every index exactly once", "[JobSystem]") {
+    JobSystem jobs(4);
+    std::vector<std::atomic<int>> visits(10000);
+
+    jobs.parallelFor(0, visits.size(), 64, [&](size_t begin, size_t end) {
+        for (auto i = begin; i < end; i++) {
+            visits[i]++;
+        }
+    });
+
+    REQUIRE(std::all_of(visits.begin(), visits.end(), [](const std::atomic<int>& v) { return v == 1; }));
+}
+
+TEST_CASE("parallelFor without workers runs on calling thread", "[JobSystem]") {
+    JobSystem jobs;
+    auto callingThread = std::this_thread::get_id();
+    size_t processed = 0;
+
+    jobs.parallelFor(10, 110, [&](size_t begin, size_t end) {
+        REQUIRE(std::this_thread::get_id() == callingThread);
+        processed += end - begin;
+    });
+
+    REQUIRE(processed == 100);
+}
+
+TEST_CASE("Nested parallelFor doesn't deadlock", "[JobSystem]") {
+    JobSystem jobs(2);
+    std::atomic<size_t> sum{0};
+
+    jobs.parallelFor(0, 16, 1, [&](size_t, size_t) {
+        jobs.parallelFor(0, 100, 10, [&](size_t begin, size_t end) { sum += end - begin; });
+    });
+
+    REQUIRE(sum == 1600u);
+}
+
+TEST_CASE("JobSystem can be restarted with different worker count", "[JobSystem]") {
+    JobSystem jobs(1);
+    REQUIRE(jobs.workerCount() == 1);
+
+    jobs.start(3);
+    REQUIRE(jobs.workerCount() == 3);
+
+    std::atomic<size_t> count{0};
+    jobs.parallelFor(0, 1000, 10, [&](size_t begin, size_t end) { count += end - begin; });
+    REQUIRE(count == 1000u);
+
+    jobs.stop();
+    REQUIRE(jobs.workerCount() == 0);
+}
@@ -0,0 +1,178 @@
+#include <catch.hpp>
+#include <atomic>
+#include <cmath>
+#include <string>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "ecs/ecs.h"
+using namespace EECS;
+
+namespace {
+size_t occurrences(const std::string& text, const std::string& pattern) {
+    size_t count = 0;
+    for (auto position = text.find(pattern); position != std::string::npos;
+         position = text.find(pattern, position + 1)) {
+        count++;
+    }
+    return count;
+}
+
+std::string trace(size_t frames = 0) {
+    std::ostringstream out;
+    Profiler::instance().writeChromeTrace(out, frames);
+    return out.str();
+}
+}
+
+TEST_CASE("Profiler records zones from many threads", "[Profiler]") {
+    auto& profiler = Profiler::instance();
+    profiler.clear();
+
+    std::vector<std::thread> threads;
+    for (auto i = 0; i < 4; i++) {
+        threads.emplace_back([]() {
+            for (auto zone = 0; zone < 100; zone++) {
+                ProfileScope scope("test", "worker \"zone\"");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    {
+        ProfileScope scope("test", typeName<int, float>());
+    }
+
+    auto json = trace();
+    REQUIRE(json.find("{\"traceEvents\":[") == 0);
+    REQUIRE(occurrences(json, "\"name\":\"worker \\\"zone\\\"\"") == 400);
+    REQUIRE(occurrences(json, "\"name\":\"int, float\"") == 1);
+    REQUIRE(occurrences(json, "\"ph\":\"X\"") == 401);
+
+    profiler.clear();
+    REQUIRE(occurrences(trace(), "\"ph\":\"X\"") == 0);
+}
+
+TEST_CASE("Profiler writes window of the last frames", "[Profiler]") {
+    auto& profiler = Profiler::instance();
+    profiler.clear();
+
+    auto frames = profiler.frameCount();
+    for (auto frame = 0; frame < 10; frame++) {
+        profiler.frame();
+        ProfileScope scope("test", "frame work");
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    profiler.frame();
+    REQUIRE(profiler.frameCount() == frames + 11);
+
+    REQUIRE(occurrences(trace(3), "\"name\":\"frame work\"") == 3);
+    REQUIRE(occurrences(trace(3), "\"name\":\"frame\"") == 3);
+    REQUIRE(occurrences(trace(), "\"name\":\"frame work\"") == 10);
+}
+
+TEST_CASE("Ring buffer of thread keeps only the newest zones", "[Profiler]") {
+    auto& profiler = Profiler::instance();
+    profiler.clear();
+
+    std::thread([&profiler]() {
+        auto time = profiler.now();
+        for (auto zone = 0u; zone < Profiler::zonesPerThread + 10; zone++) {
+            profiler.record("test", zone < 10 ? "oldest" : "newest", time, time);
+        }
+    }).join();
+
+    auto json = trace();
+    REQUIRE(occurrences(json, "\"name\":\"oldest\"") == 0);
+    REQUIRE(occurrences(json, "\"name\":\"newest\"") == Profiler::zonesPerThread);
+    profiler.clear();
+}
+
+TEST_CASE("Zones exported while the ring wraps aren't torn", "[Profiler]") {
+    auto& profiler = Profiler::instance();
+    profiler.clear();
+
+    // zone i is named after i % 3, and both its begin(mod 3) and duration equal i % 3. Ring size isn't divisible by 3,
+    // so zone mixed from two records which share a slot doesn't match its name.
+    const char* names[] = {"zero", "one", "two"};
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> recorded{0};
+    auto base = (profiler.now() / 3 + 1) * 3;
+    std::thread writer([&]() {
+        for (int64_t zone = 0; !stop; zone++) {
+            auto kind = zone % 3;
+            profiler.record("test", names[kind], base + zone * 3 + kind, base + zone * 3 + kind * 2);
+            recorded.store((size_t)zone + 1, std::memory_order_relaxed);
+            // slowed down, so even slow(sanitized) exports copy something before it's overwritten, but still wrap
+            if (zone % 64 == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(10));
+            }
+        }
+    });
+
+    // exports start once the ring has wrapped, so they always race with overwriting
+    while (recorded.load(std::memory_order_relaxed) <= Profiler::zonesPerThread) {
+        std::this_thread::yield();
+    }
+
+    size_t checked = 0;
+    size_t torn = 0;
+    for (auto exports = 0; exports < 20; exports++) {
+        std::istringstream json(trace());
+        std::string line;
+        while (std::getline(json, line)) {
+            for (auto kind = 0; kind < 3; kind++) {
+                if (line.find(std::string("\"name\":\"") + names[kind] + "\"") == std::string::npos) {
+                    continue;
+                }
+
+                auto begin = std::llround(std::stod(line.substr(line.find("\"ts\":") + 5)) * 1000);
+                auto duration = std::llround(std::stod(line.substr(line.find("\"dur\":") + 6)) * 1000);
+                if (begin % 3 != kind || duration != kind) {
+                    torn++;
+                }
+                checked++;
+            }
+        }
+    }
+    stop = true;
+    writer.join();
+
+    REQUIRE(checked > 0);
+    REQUIRE(torn == 0);
+    profiler.clear();
+}
+
+#ifdef EECS_PROFILER
+struct ProfiledEvent : Event<ProfiledEvent> {};
+struct ProfiledComponent : Component<ProfiledComponent> {};
+
+class ProfiledTask : public Task<ProfiledTask> {
+   public:
+    ProfiledTask(ECS& engine) : Task(engine) {}
+
+    void update() {
+        ecs.components.intersection<ProfiledComponent>();
+        ecs.events.emplace<ProfiledEvent>();
+    }
+};
+
+TEST_CASE("Tasks, events and queries are profiled automatically", "[Profiler]") {
+    ECS engine;
+    auto& profiler = Profiler::instance();
+    profiler.clear();
+
+    engine.components.addComponent<ProfiledComponent>(engine.entities.addEntity());
+    engine.tasks.addTask<ProfiledTask>()->frequency = std::chrono::milliseconds(1);
+    engine.tasks.update(std::chrono::milliseconds(1));
+    engine.events.emit();
+
+    auto json = trace();
+    REQUIRE(occurrences(json, "\"name\":\"ProfiledTask\",\"cat\":\"task\"") == 1);
+    REQUIRE(occurrences(json, "\"name\":\"ProfiledComponent\",\"cat\":\"query\"") == 1);
+    REQUIRE(occurrences(json, "\"name\":\"ProfiledEvent\",\"cat\":\"event\"") == 1);
+    REQUIRE(occurrences(json, "\"name\":\"EventQueue::emit\"") == 1);
+}
+#endif
@@ -0,0 +1,114 @@
+#include <catch.hpp>
+#include <cstdint>
+#include "ecs/ecs.h"
+using namespace EECS;
+
+struct SoABody : public Component<SoABody> {
+    SoABody(float x = 0, float y = 0, float velocity = 0, int mass = 1)
+        : x(x), y(y), velocity(velocity), mass(mass) {}
+
+    float x, y;
+    float velocity;
+    int mass;
+
+    using Storage = SoAStorage;
+    using Fields = FieldList<EECS_FIELD(&SoABody::x), EECS_FIELD(&SoABody::y), EECS_FIELD(&SoABody::velocity),
+                             EECS_FIELD(&SoABody::mass)>;
+};
+
+TEST_CASE("SoA storage: adding, accessing and deleting components", "[SoA]") {
+    ComponentManager comps;
+
+    auto first = comps.addComponent<SoABody>(1, 1.f, 2.f, 3.f, 4);
+    REQUIRE(first);
+    REQUIRE(first.entity() == 1);
+    REQUIRE(first.get(&SoABody::x) == 1.f);
+    REQUIRE(first.field<3>() == 4);
+
+    comps.addComponent<SoABody>(2, 10.f, 20.f);
+    comps.addComponent<SoABody>(3, 100.f);
+    REQUIRE(comps.columns<SoABody>().size() == 3);
+
+    // reference finds its component on each access, so it survives other additions and deletions
+    REQUIRE(comps.deleteComponent<SoABody>(1));
+    REQUIRE_FALSE(first);
+    REQUIRE(comps.getComponent<SoABody>(1) == nullptr);
+    auto third = comps.getComponent<SoABody>(3);
+    REQUIRE(third.get(&SoABody::x) == 100.f);
+    REQUIRE_FALSE(comps.deleteComponent<SoABody>(1));
+
+    third.get(&SoABody::velocity) = 7.f;
+    auto loaded = third.load();
+    REQUIRE(loaded.entityID == 3);
+    REQUIRE(loaded.x == 100.f);
+    REQUIRE(loaded.velocity == 7.f);
+
+    loaded.mass = 42;
+    third.store(loaded);
+    REQUIRE(comps.getComponent<SoABody>(3).get(&SoABody::mass) == 42);
+
+    // replacement
+    comps.addComponent<SoABody>(2, 5.f);
+    REQUIRE(comps.getComponent<SoABody>(2).get(&SoABody::x) == 5.f);
+    REQUIRE(comps.getComponent<SoABody>(2).get(&SoABody::y) == 0.f);
+    REQUIRE(comps.columns<SoABody>().size() == 2);
+
+    comps.clear<SoABody>();
+    REQUIRE(comps.columns<SoABody>().size() == 0);
+    REQUIRE(comps.getComponent<SoABody>(2) == nullptr);
+}
+
+TEST_CASE("SoA storage: processing columns", "[SoA]") {
+    ComponentManager comps;
+    const int count = 1000;
+
+    for (auto i = 1; i <= count; i++) {
+        comps.addComponent<SoABody>(i, (float)i, 0.f, 2.f);
+    }
+    for (auto i = 1; i <= count; i += 3) {
+        comps.deleteComponent<SoABody>(i);
+    }
+
+    auto& bodies = comps.columns<SoABody>();
+    auto xs = bodies.column(&SoABody::x);
+    auto velocities = bodies.column<2>();
+    auto entities = bodies.entities();
+
+    REQUIRE(xs.size() == bodies.size());
+    REQUIRE(velocities.size() == bodies.size());
+    REQUIRE(((uintptr_t)xs.data() % 64 == 0));
+    REQUIRE(((uintptr_t)velocities.data() % 64 == 0));
+
+    for (auto i = 0u; i < xs.size(); i++) {
+        xs[i] += velocities[i];
+    }
+
+    for (auto i = 0u; i < entities.size(); i++) {
+        REQUIRE(xs[i] == (float)entities[i] + 2.f);
+    }
+
+    for (auto i = 1; i <= count; i++) {
+        auto body = comps.getComponent<SoABody>(i);
+        REQUIRE((bool)body == ((i - 1) % 3 != 0));
+        if (body) {
+            REQUIRE(body.get(&SoABody::x) == (float)i + 2.f);
+        }
+    }
+}
+
+TEST_CASE("SoA storage: entities with SoA-stored components", "[SoA]") {
+    ComponentManager comps;
+    EntityManager entities(comps);
+    comps.setEntityManager(entities);
+
+    auto entity = entities.addEntity();
+    REQUIRE(comps.addComponent<SoABody>(entity, 3.f, 4.f));
+    REQUIRE_FALSE(comps.addComponent<SoABody>(entity.getID() + 1000));
+
+    auto clone = entity.clone();
+    REQUIRE(comps.getComponent<SoABody>(clone).get(&SoABody::y) == 4.f);
+
+    entity.destroy();
+    REQUIRE(comps.columns<SoABody>().size() == 1);
+    REQUIRE(comps.columns<SoABody>().entities()[0] == clone.getID());
+}